@@ -36,24 +36,65 @@ FORMS += \
 HEADERS += \
     src/assembler/Assembler.h \
     src/assembler/Disassembler.h \
+    src/assembler/DisassemblyCache.h \
+    src/assembler/FlowAnalyzer.h \
+    src/assembler/Optimizer.h \
+    src/assembler/TimingAnalyzer.h \
     src/core/Core.h \
+    src/core/TerminalDisplay.h \
+    src/devices/Acia6850.h \
+    src/devices/BankController.h \
+    src/devices/BlockDevice.h \
+    src/devices/DeviceBus.h \
+    src/devices/KeyboardController.h \
+    src/devices/PointerDevice.h \
+    src/dialogs/CharacterDisplay.h \
     src/dialogs/FocusAwareLineEdit.h \
+    src/dialogs/FramebufferDisplay.h \
     src/processor/Processor.h \
     src/dialogs/ExternalDisplay.h \
     src/dialogs/InstructionInfoDialog.h \
+    src/dialogs/LineGutter.h \
+    src/dialogs/PerformanceDialog.h \
+    src/dialogs/SerialConsole.h \
+    src/mainwindow/CodeHighlighter.h \
     src/mainwindow/MainWindow.h \
-    src/utils/ActionQueue.h
+    src/mainwindow/MemoryTableModel.h \
+    src/utils/ActionQueue.h \
+    src/utils/AutosaveWriter.h \
+    src/utils/RingBuffer.h \
+    src/utils/SerialHost.h
 
 SOURCES += \
     src/assembler/Assembler.cpp \
     src/assembler/Disassembler.cpp \
+    src/assembler/DisassemblyCache.cpp \
+    src/assembler/FlowAnalyzer.cpp \
+    src/assembler/Optimizer.cpp \
+    src/assembler/TimingAnalyzer.cpp \
     src/core/Core.cpp \
+    src/core/TerminalDisplay.cpp \
     src/core/main.cpp \
+    src/devices/Acia6850.cpp \
+    src/devices/BankController.cpp \
+    src/devices/BlockDevice.cpp \
+    src/devices/DeviceBus.cpp \
+    src/devices/KeyboardController.cpp \
+    src/devices/PointerDevice.cpp \
+    src/mainwindow/CodeHighlighter.cpp \
     src/mainwindow/CodeMarkingSys.cpp \
     src/processor/InstructionFunctions.cpp \
     src/processor/Processor.cpp \
+    src/dialogs/CharacterDisplay.cpp \
     src/dialogs/ExternalDisplay.cpp \
+    src/dialogs/FramebufferDisplay.cpp \
     src/dialogs/InstructionInfoDialog.cpp \
+    src/dialogs/LineGutter.cpp \
+    src/dialogs/PerformanceDialog.cpp \
+    src/dialogs/SerialConsole.cpp \
     src/mainwindow/FileManager.cpp \
     src/mainwindow/MainWindow.cpp \
-    src/mainwindow/MainWindowSlots.cpp
+    src/mainwindow/MainWindowSlots.cpp \
+    src/mainwindow/MemoryTableModel.cpp \
+    src/utils/AutosaveWriter.cpp \
+    src/utils/SerialHost.cpp
@@ -15,6 +15,10 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "src/assembler/Assembler.h"
+#include "src/assembler/Optimizer.h"
+
+#include <algorithm>
+#include <memory>
 
 using Core::AddressingMode;
 using Core::AssemblyError;
@@ -179,8 +183,33 @@ namespace Err {
   inline static QString mixedIMMandIND() {
     return "Immediate and indexed data may not be mixed";
   }
+
+  // Bank Errors
+  inline static QString banksNotConfigured() {
+    return "Memory banks are not configured, there is no bank to select.";
+  }
+  inline static QString bankOutOfRange(int bank, int bankCount) {
+    return "Bank " + QString::number(bank) + " does not exist, banks are numbered 0 to " + QString::number(bankCount - 1) + ".";
+  }
 } // namespace Err
 
+/**
+ * @brief Returns the location of the byte after the given one, wrapping like the address does.
+ */
+int Assembler::OutputImage::next(int location) const {
+  uint16_t address = (location + 1) & 0xFFFF;
+  return location > 0xFFFF && layout.contains(address) ? (location & ~0xFFFF) | address : address;
+}
+
+uint8_t &Assembler::OutputImage::at(int location) {
+  if (location <= 0xFFFF) {
+    return memory[location];
+  }
+  std::vector<uint8_t> &contents = banks[location >> 16];
+  contents.resize(layout.windowSize);
+  return contents[(location & 0xFFFF) - layout.windowStart];
+}
+
 /**
  * @brief Parses decimal string with optional negative values.
  * 
@@ -756,6 +785,143 @@ Assembler::LineParts Assembler::disectLine(QString line, int assemblerLine) {
 /**
  * @brief Assembles the input assembly code into machine code.
  *
+ * Without peephole optimization this is a single layout run. With it, the code is assembled once,
+ * the optimizer rewrites source lines in place and the rewritten code is assembled again, repeating
+ * while new rewrites are found. Rewritten lines keep their line numbers, so the assembly map of the
+ * optimized code still points into the original source. The changed lines, the cycle counts of the
+ * changed routines and the JMP instructions which could be shortened are reported.
+ *
+ * @param processorVersion The version of the processor for which the code is being assembled.
+ * @param code The input assembly code as a QString.
+ * @param Memory The output memory buffer where the assembled machine code will be stored.
+ * @param options Optional optimizations applied while assembling.
+ * @return AssemblyResult containing messages, errors, and the assembly map.
+ */
+AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &Memory, const Core::AssemblyOptions &options) {
+  if (!options.peepholeOptimization) {
+    return assembleLayout(processorVersion, code, Memory, options);
+  }
+
+  const auto initialMemory = std::make_unique<std::array<uint8_t, 0x10000>>(Memory);
+  const AssemblyResult original = assembleLayout(processorVersion, code, Memory, options);
+  if (!original.error.ok) {
+    return original;
+  }
+
+  QStringList lines = code.split('\n');
+  AssemblyResult result = original;
+  std::vector<Optimizer::Rewrite> appliedRewrites;
+  int pass = 0;
+  while (pass < maxPeepholePasses) {
+    const std::vector<Optimizer::Rewrite> rewrites = Optimizer::findPeepholeRewrites(processorVersion, lines, result.assemblyMap);
+    if (rewrites.empty()) {
+      break;
+    }
+    pass++;
+    for (const Optimizer::Rewrite &rewrite : rewrites) {
+      lines[rewrite.lineNumber] = rewrite.replacement;
+    }
+
+    Memory = *initialMemory;
+    result = assembleLayout(processorVersion, lines.join('\n'), Memory, options);
+    if (!result.error.ok) {
+      Memory = *initialMemory;
+      result = assembleLayout(processorVersion, code, Memory, options);
+      result.messages.append(Msg{MsgType::WARN, "Peephole optimization skipped, the optimized code failed to assemble: " + result.error.message});
+      return result;
+    }
+    appliedRewrites.insert(appliedRewrites.end(), rewrites.begin(), rewrites.end());
+  }
+
+  std::sort(appliedRewrites.begin(), appliedRewrites.end(), [](const Optimizer::Rewrite &a, const Optimizer::Rewrite &b) { return a.lineNumber < b.lineNumber; });
+  for (const Optimizer::Rewrite &rewrite : appliedRewrites) {
+    result.messages.append(Msg{MsgType::DEBUG, QString("Line %1: %2").arg(rewrite.lineNumber).arg(rewrite.description)});
+  }
+  if (!appliedRewrites.empty()) {
+    result.messages.append(Optimizer::compareRoutineCycles(processorVersion, code.split('\n'), original.assemblyMap, result.assemblyMap));
+  }
+  result.messages.append(Optimizer::findShortJumpCandidates(processorVersion, result.assemblyMap));
+  result.messages.append(Msg{MsgType::DEBUG, QString("Peephole optimization: %1 line(s) rewritten in %2 pass(es)").arg(appliedRewrites.size()).arg(pass)});
+  return result;
+}
+
+/**
+ * @brief Assembles the input code and settles its layout.
+ *
+ * Runs a single assembly pass, or, when direct addressing optimization is enabled, repeats the
+ * pass until the layout reaches a fixpoint. Forward referenced operands are always encoded with
+ * extended addressing in a single pass because their value is unknown when the instruction size
+ * is decided. Every further pass forces direct addressing on the lines whose operand resolved into
+ * the direct page ($00-$FF) in the previous pass. Shrinking an instruction can only move labels
+ * down, so the set of direct lines normally only grows. Lines whose operand leaves the direct page
+ * after a layout change are reverted to extended addressing and never retried.
+ *
+ * @param processorVersion The version of the processor for which the code is being assembled.
+ * @param code The input assembly code as a QString.
+ * @param Memory The output memory buffer where the assembled machine code will be stored.
+ * @param options Optional optimizations applied while assembling.
+ * @return AssemblyResult containing messages, errors, and the assembly map.
+ */
+AssemblyResult Assembler::assembleLayout(ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &Memory, const Core::AssemblyOptions &options) {
+  DirectAddressingPassInfo passInfo;
+  if (!options.optimizeDirectAddressing) {
+    return assemblePass(processorVersion, code, Memory, options.banks, {}, passInfo);
+  }
+
+  const auto initialMemory = std::make_unique<std::array<uint8_t, 0x10000>>(Memory);
+  std::set<int> directLines;
+  std::set<int> blockedLines;
+  AssemblyResult result;
+  int pass = 0;
+  while (true) {
+    pass++;
+    Memory = *initialMemory;
+    passInfo = DirectAddressingPassInfo{};
+    result = assemblePass(processorVersion, code, Memory, options.banks, directLines, passInfo);
+    if (!result.error.ok) {
+      return result;
+    }
+
+    if (!passInfo.failedLines.empty()) {
+      for (int line : passInfo.failedLines) {
+        directLines.erase(line);
+        blockedLines.insert(line);
+      }
+      continue;
+    }
+
+    bool layoutChanged = false;
+    if (pass < maxDirectOptimizationPasses) {
+      for (int line : passInfo.candidateLines) {
+        if (blockedLines.count(line) == 0 && directLines.insert(line).second) {
+          layoutChanged = true;
+        }
+      }
+    }
+    if (!layoutChanged) {
+      break;
+    }
+  }
+
+  int savedCycles = 0;
+  for (const auto &[line, cycles] : passInfo.directLineSavings) {
+    const AssemblyMap::MappedInstr &instruction = result.assemblyMap.getObjectByLine(line);
+    result.messages.append(Msg{MsgType::DEBUG,
+                               QString("Line %1: '%2 %3' encoded with direct addressing, saved 1 byte and %4 cycle(s)").arg(line).arg(instruction.IN, instruction.OP).arg(cycles)});
+    savedCycles += cycles;
+  }
+  result.messages.append(Msg{MsgType::DEBUG,
+                             QString("Direct addressing optimization: %1 line(s) shortened in %2 pass(es), saved %3 byte(s) and %4 cycle(s)")
+                                 .arg(passInfo.directLineSavings.size())
+                                 .arg(pass)
+                                 .arg(passInfo.directLineSavings.size())
+                                 .arg(savedCycles)});
+  return result;
+}
+
+/**
+ * @brief Runs a single assembly pass over the input code.
+ *
  * This function processes the input assembly code, validates instructions and operands,
  * and generates the corresponding machine code in the output memory buffer.
  * It also handles label assignments, error checking, and message logging.
@@ -763,22 +929,41 @@ Assembler::LineParts Assembler::disectLine(QString line, int assemblerLine) {
  * @param processorVersion The version of the processor for which the code is being assembled.
  * @param code The input assembly code as a QString.
  * @param Memory The output memory buffer where the assembled machine code will be stored.
- * @return AssemblyResult containing messages, errors, and the assembly map.
+ * @param bankLayout The bank window, code of .BANK sections in it is collected in the result.
+ * @param directLines Lines whose forward referenced operand is encoded with direct addressing.
+ * @param passInfo Receives the direct addressing candidates and failures found in this pass.
+ * @return AssemblyResult containing messages, errors, the assembly map and the label values.
  *
  * @note The function throws AssemblyError for various syntax and semantic errors in the input code.
  */
-AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &Memory) {
+AssemblyResult Assembler::assemblePass(ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &Memory, const Core::BankLayout &bankLayout, const std::set<int> &directLines,
+                                       DirectAddressingPassInfo &passInfo) {
   int assemblerLine = 0;
   uint16_t assemblerAddress = 0;
 
   std::map<QString, int> labelValMap;
-  std::map<uint16_t, QString> callLabelMap;
-  std::map<uint16_t, QString> callLabelRelMap;
-  std::map<uint16_t, QString> callLabelExtMap;
+  std::map<int, QString> callLabelMap;
+  std::map<int, QString> callLabelRelMap;
+  std::map<int, QString> callLabelExtMap;
+  std::map<int, QString> callLabelDirMap;
+  std::set<int> directCandidateLocations;
+  std::map<int, int> deferredLines; // line of each operand resolved after the last line
 
   QList<Msg> messages;
   AssemblyError assemblyError = AssemblyError::none();
   AssemblyMap assemblyMap;
+  OutputImage image{Memory, bankLayout, {}, 0};
+  if (bankLayout.enabled()) {
+    assemblyMap.setBankWindow(bankLayout.windowStart, bankLayout.windowSize);
+  }
+
+  // operands referencing labels are resolved once every label is known, keyed by the location of their first byte
+  auto deferOperand = [&](std::map<int, QString> &operands, const QString &expr) {
+    int location = image.locate((assemblerAddress + 1) & 0xFFFF);
+    operands[location] = expr;
+    deferredLines[location] = assemblerLine;
+    return location;
+  };
 
   bool HCFwarn = false; // should the assembler warn that there are potential Halt-and-Catch-Fire instructions in the machine code
 
@@ -798,8 +983,8 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
       uint8_t operand1 = 0;
       uint8_t operand2 = 0;
 
-      if (assemblerAddress > 0xFFF0) {
-        messages.append({MsgType::WARN, QString("Instruction on line: %1 overwrites input buffers or interrupt vectors.").arg(assemblerLine)});
+      if (assemblerAddress >= Core::deviceRegistersStart) {
+        messages.append({MsgType::WARN, QString("Instruction on line: %1 overwrites device registers, input buffers or interrupt vectors.").arg(assemblerLine)});
       }
 
       if (trimLineAndCheckEmpty(line)) {
@@ -844,7 +1029,7 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
             validateValueRange(value, 0xFF, assemblerLine);
 
-            Memory[assemblerAddress++] = value;
+            image[assemblerAddress++] = value;
           }
         } else if (s_in == ".EQU") {
           errorCheckMissingOperand(s_op, assemblerLine);
@@ -866,11 +1051,27 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
           }
           uint16_t value = result.value;
 
-          Memory[Core::interruptLocations - 1] = value >> 8;
-          Memory[Core::interruptLocations] = value & 0xFF;
+          image[Core::interruptLocations - 1] = value >> 8;
+          image[Core::interruptLocations] = value & 0xFF;
           assemblerAddress = value;
 
           assignLabelValue(label, assemblerAddress, labelValMap, assemblerLine);
+        } else if (s_in == ".BANK") {
+          errorCheckMissingOperand(s_op, assemblerLine);
+          if (!bankLayout.enabled()) {
+            throw AssemblyError::failure(Err::banksNotConfigured(), assemblerLine, -1);
+          }
+
+          auto result = expressionEvaluator(s_op, labelValMap, true);
+          if (!result.ok) {
+            throw AssemblyError::failure(result.message, assemblerLine, -1);
+          }
+          if (result.value >= bankLayout.bankCount) {
+            throw AssemblyError::failure(Err::bankOutOfRange(result.value, bankLayout.bankCount), assemblerLine, -1);
+          }
+          image.bank = result.value;
+
+          assignLabelValue(label, image.bank, labelValMap, assemblerLine);
         } else if (s_in == ".WORD") {
           errorCheckMissingOperand(s_op, assemblerLine);
 
@@ -891,8 +1092,8 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
             operand1 = (value >> 8) & 0xFF;
             operand2 = value & 0xFF;
 
-            Memory[assemblerAddress++] = operand1;
-            Memory[assemblerAddress++] = operand2;
+            image[assemblerAddress++] = operand1;
+            image[assemblerAddress++] = operand2;
           }
         } else if (s_in == ".RMB") {
           errorCheckMissingOperand(s_op, assemblerLine);
@@ -935,8 +1136,9 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
           operand1 = (val >> 8) & 0xFF;
           operand2 = val & 0xFF;
-          Memory[adr] = operand1;
-          Memory[(adr + 1) & 0xFFFF] = operand2;
+          image[adr] = operand1;
+          image[(adr + 1) & 0xFFFF] = operand2;
+          assemblyMap.addRange(adr, 2, assemblerLine);
 
           assignLabelValue(label, adr, labelValMap, assemblerLine);
         } else if (s_in == ".SETB") {
@@ -966,7 +1168,8 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
           uint16_t val = result.value;
 
           validateValueRange(val, 0xFF, assemblerLine);
-          Memory[adr] = val;
+          image[adr] = val;
+          assemblyMap.addRange(adr, 1, assemblerLine);
 
           assignLabelValue(label, adr, labelValMap, assemblerLine);
         } else if (s_in == ".STR") {
@@ -986,12 +1189,16 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
             if (number >= 128) {
               throw AssemblyError::failure(Err::invalidAsciiCharacter(QString(s_op.at(i))), assemblerLine, -1);
             }
-            Memory[assemblerAddress++] = static_cast<uint8_t>(number);
+            image[assemblerAddress++] = static_cast<uint8_t>(number);
           }
         }
 
         bool hasLocation = (Core::directivesWithLocation.contains(s_in));
-        assemblyMap.addInstruction(hasLocation ? instructionAddress : -1, assemblerLine, opCode, operand1, operand2, s_in, s_op);
+        int instructionBank = image.locate(instructionAddress) >> 16;
+        assemblyMap.addInstruction(hasLocation ? instructionAddress : -1, assemblerLine, opCode, operand1, operand2, s_in, s_op, instructionBank);
+        if (hasLocation || s_in == ".RMB") {
+          assemblyMap.addRange(instructionAddress, static_cast<uint16_t>(assemblerAddress - instructionAddress), assemblerLine, instructionBank);
+        }
       } else {
         assignLabelValue(label, assemblerAddress, labelValMap, assemblerLine);
 
@@ -1001,7 +1208,7 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
           opCode = tempCodeINH;
           validateInstructionSupport(s_in, opCode, processorVersion, assemblerLine);
 
-          Memory[assemblerAddress++] = opCode;
+          image[assemblerAddress++] = opCode;
         } else {
           errorCheckMissingOperand(s_op, assemblerLine);
 
@@ -1013,7 +1220,7 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
             validateInstructionSupport(s_in, opCode, processorVersion, assemblerLine);
 
             if (s_op[0].isLetter()) {
-              callLabelRelMap[(assemblerAddress + 1) & 0xFFFF] = s_op;
+              deferOperand(callLabelRelMap, s_op);
               operand1 = 0;
             } else {
               NumParseRelativeResult resultVal = parseNumberRelative(s_op);
@@ -1022,8 +1229,8 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
               operand1 = resultVal.value;
             }
-            Memory[assemblerAddress++] = opCode;
-            Memory[assemblerAddress++] = operand1;
+            image[assemblerAddress++] = opCode;
+            image[assemblerAddress++] = operand1;
           } else if (s_op.contains(',')) { // IND
             errorCheckOperandIMMINDMixed(s_op, assemblerLine);
 
@@ -1045,7 +1252,7 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
               operand1 = 0;
             } else if (isLabelOrExpression(s_op)) {
               s_op.chop(2);
-              callLabelMap[(assemblerAddress + 1) & 0xFFFF] = s_op;
+              deferOperand(callLabelMap, s_op);
             } else {
               s_op.chop(2);
 
@@ -1060,8 +1267,8 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
               operand1 = value;
             }
 
-            Memory[assemblerAddress++] = opCode;
-            Memory[assemblerAddress++] = operand1;
+            image[assemblerAddress++] = opCode;
+            image[assemblerAddress++] = operand1;
           } else if (s_op.startsWith("#")) { // IMM
             s_op = s_op.sliced(1);
 
@@ -1072,7 +1279,7 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
             if (getInstructionMode(processorVersion, opCode) == AddressingMode::IMMEXT) {
               if (isLabelOrExpression(s_op)) {
-                callLabelExtMap[(assemblerAddress + 1) & 0xFFFF] = s_op;
+                deferOperand(callLabelExtMap, s_op);
               } else {
                 NumParseResult resultVal = parseNumber(s_op);
                 if (!resultVal.ok) {
@@ -1083,12 +1290,12 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
                 operand1 = (value >> 8) & 0xFF;
                 operand2 = value & 0xFF;
               }
-              Memory[assemblerAddress++] = opCode;
-              Memory[assemblerAddress++] = operand1;
-              Memory[assemblerAddress++] = operand2;
+              image[assemblerAddress++] = opCode;
+              image[assemblerAddress++] = operand1;
+              image[assemblerAddress++] = operand2;
             } else {
               if (isLabelOrExpression(s_op)) {
-                callLabelMap[(assemblerAddress + 1) & 0xFFFF] = s_op;
+                deferOperand(callLabelMap, s_op);
               } else {
                 NumParseResult resultVal = parseNumber(s_op);
                 if (!resultVal.ok) {
@@ -1100,8 +1307,8 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
                 operand1 = value;
               }
-              Memory[assemblerAddress++] = opCode;
-              Memory[assemblerAddress++] = operand1;
+              image[assemblerAddress++] = opCode;
+              image[assemblerAddress++] = operand1;
             }
           } else { // DIR/EXT
             bool skipDir = false;
@@ -1113,8 +1320,19 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
               }
 
               if (result.undefined) {
-                skipDir = true;
-                callLabelExtMap[(assemblerAddress + 1) & 0xFFFF] = s_op;
+                uint8_t dirCode = mnemonicInfo.opCodes[Core::addressingModes[AddressingMode::DIR].id];
+                uint8_t extCode = mnemonicInfo.opCodes[Core::addressingModes[AddressingMode::EXT].id];
+                bool dirAvailable = dirCode != 0 && extCode != 0 && getInstructionSupported(processorVersion, dirCode);
+                if (dirAvailable && directLines.count(assemblerLine) != 0) {
+                  deferOperand(callLabelDirMap, s_op);
+                  passInfo.directLineSavings[assemblerLine] = getInstructionCycleCount(processorVersion, extCode) - getInstructionCycleCount(processorVersion, dirCode);
+                } else {
+                  skipDir = true;
+                  int location = deferOperand(callLabelExtMap, s_op);
+                  if (dirAvailable) {
+                    directCandidateLocations.insert(location);
+                  }
+                }
               } else {
                 value = result.value;
               }
@@ -1135,17 +1353,17 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
               if (getInstructionSupported(processorVersion, opCode)) {
                 operand1 = value;
-                Memory[assemblerAddress++] = opCode;
-                Memory[assemblerAddress++] = operand1;
+                image[assemblerAddress++] = opCode;
+                image[assemblerAddress++] = operand1;
               } else if (mnemonicInfo.opCodes[Core::addressingModes[AddressingMode::EXT].id] != 0) {
                 opCode = mnemonicInfo.opCodes[Core::addressingModes[AddressingMode::EXT].id];
                 validateInstructionSupport(s_in, opCode, processorVersion, assemblerLine);
 
                 operand1 = (value >> 8) & 0xFF;
                 operand2 = value & 0xFF;
-                Memory[assemblerAddress++] = opCode;
-                Memory[assemblerAddress++] = operand1;
-                Memory[assemblerAddress++] = operand2;
+                image[assemblerAddress++] = opCode;
+                image[assemblerAddress++] = operand1;
+                image[assemblerAddress++] = operand2;
               } else {
                 throw AssemblyError::failure(Err::mnemonicDoesNotSupportAddressingMode(s_in, AddressingMode::EXT), assemblerLine, -1);
               }
@@ -1155,9 +1373,9 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
               operand1 = (value >> 8) & 0xFF;
               operand2 = value & 0xFF;
-              Memory[assemblerAddress++] = opCode;
-              Memory[assemblerAddress++] = operand1;
-              Memory[assemblerAddress++] = operand2;
+              image[assemblerAddress++] = opCode;
+              image[assemblerAddress++] = operand1;
+              image[assemblerAddress++] = operand2;
             } else {
               throw AssemblyError::failure(Err::mnemonicDoesNotSupportAddressingMode(s_in, AddressingMode::EXT), assemblerLine, -1);
             }
@@ -1166,13 +1384,15 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
         if (opCode == 0x9D || opCode == 0xDD) {
           HCFwarn = true;
         }
-        assemblyMap.addInstruction(instructionAddress, assemblerLine, opCode, operand1, operand2, s_in, s_op);
+        int instructionBank = image.locate(instructionAddress) >> 16;
+        assemblyMap.addInstruction(instructionAddress, assemblerLine, opCode, operand1, operand2, s_in, s_op, instructionBank);
+        assemblyMap.addRange(instructionAddress, getInstructionLength(processorVersion, opCode), assemblerLine, instructionBank);
       }
     }
     // second pass/passes to resolve undefined expr or labels
     for (const auto &[location, expr] : callLabelMap) {
-      auto &instruction = assemblyMap.getObjectByAddress(location - 1);
-      assemblerLine = instruction.lineNumber;
+      assemblerLine = deferredLines[location];
+      const auto &instruction = assemblyMap.getObjectByLine(assemblerLine);
       auto result = expressionEvaluator(expr, labelValMap, true);
       if (!result.ok) {
         throw AssemblyError::failure(result.message, assemblerLine, -1);
@@ -1180,25 +1400,44 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
 
       validateValueRange(result.value, 0xFF, assemblerLine);
 
-      Memory[location] = result.value;
-      instruction.byte2 = result.value;
+      image.at(location) = result.value;
+      assemblyMap.setOperandBytes(assemblerLine, result.value, instruction.byte3);
     }
     for (const auto &[location, expr] : callLabelExtMap) {
-      auto &instruction = assemblyMap.getObjectByAddress(location - 1);
-      assemblerLine = instruction.lineNumber;
+      assemblerLine = deferredLines[location];
       auto result = expressionEvaluator(expr, labelValMap, true);
       if (!result.ok) {
         throw AssemblyError::failure(result.message, assemblerLine, -1);
       }
 
-      Memory[location] = (result.value >> 8) & 0xFF;
-      Memory[(location + 1) & 0xFFFF] = result.value & 0xFF;
-      instruction.byte2 = Memory[location];
-      instruction.byte3 = Memory[(location + 1) & 0xFFFF];
+      image.at(location) = (result.value >> 8) & 0xFF;
+      image.at(image.next(location)) = result.value & 0xFF;
+      assemblyMap.setOperandBytes(assemblerLine, image.at(location), image.at(image.next(location)));
+
+      if (result.value <= 0xFF && directCandidateLocations.count(location) != 0) {
+        passInfo.candidateLines.insert(assemblerLine);
+      }
+    }
+    for (const auto &[location, expr] : callLabelDirMap) {
+      assemblerLine = deferredLines[location];
+      const auto &instruction = assemblyMap.getObjectByLine(assemblerLine);
+      auto result = expressionEvaluator(expr, labelValMap, true);
+      if (!result.ok) {
+        throw AssemblyError::failure(result.message, assemblerLine, -1);
+      }
+
+      if (result.value > 0xFF) {
+        // the layout moved the operand out of the direct page, the caller reverts this line to EXT
+        passInfo.failedLines.insert(assemblerLine);
+        passInfo.directLineSavings.erase(assemblerLine);
+        continue;
+      }
+      image.at(location) = result.value;
+      assemblyMap.setOperandBytes(assemblerLine, result.value, instruction.byte3);
     }
     for (const auto &[location, label] : callLabelRelMap) {
-      auto &instruction = assemblyMap.getObjectByAddress(location - 1);
-      assemblerLine = instruction.lineNumber;
+      assemblerLine = deferredLines[location];
+      const auto &instruction = assemblyMap.getObjectByLine(assemblerLine);
       if (labelValMap.count(label) == 0) {
         if (label.contains('+') || label.contains('-')) {
           throw AssemblyError::failure("Cannot use expressions with relative addressing.", assemblerLine, -1);
@@ -1208,14 +1447,14 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
       } else {
         uint16_t location2 = labelValMap[label];
         int value;
-        value = location2 - location - 1;
+        value = location2 - (location & 0xFFFF) - 1;
         if (value > 127 || value < -128) {
           throw AssemblyError::failure(Err::numOutOfRelRange(value), assemblerLine, -1);
         }
         int8_t signedValue = static_cast<int8_t>(value);
         value = signedValue & 0xFF;
-        Memory[location] = value;
-        instruction.byte2 = value;
+        image.at(location) = value;
+        assemblyMap.setOperandBytes(assemblerLine, value, instruction.byte3);
       }
     }
   } catch (AssemblyError &e) {
@@ -1234,5 +1473,5 @@ AssemblyResult Assembler::assemble(ProcessorVersion processorVersion, const QStr
   for (auto it = labelValMap.rbegin(); it != labelValMap.rend(); ++it) {
     messages.prepend(Msg{MsgType::DEBUG, "Value: $" + QString::number(it->second, 16) + " assigned to label '" + it->first + "'"});
   }
-  return AssemblyResult{messages, assemblyError, assemblyMap};
+  return AssemblyResult{messages, assemblyError, assemblyMap, labelValMap, image.banks};
 }
@@ -22,13 +22,23 @@
 #include <QString>
 
 #include <map>
+#include <set>
 #include <stdint.h>
 
 class Assembler {
 public:
-  static Core::AssemblyResult assemble(Core::ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &memory);
+  static Core::AssemblyResult assemble(Core::ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &memory, const Core::AssemblyOptions &options = {});
 
 private:
+  static constexpr int maxDirectOptimizationPasses = 16;
+  static constexpr int maxPeepholePasses = 4;
+
+  struct DirectAddressingPassInfo {
+    std::set<int> candidateLines;         // forward referenced EXT operands which resolved into the direct page
+    std::set<int> failedLines;            // lines forced to DIR whose operand resolved outside the direct page
+    std::map<int, int> directLineSavings; // line -> cycles saved by encoding the line with DIR instead of EXT
+  };
+
   enum ExprOperation {
     PLUS,
     MINUS,
@@ -67,6 +77,20 @@ private:
     static ExpressionEvaluationResult failure(const QString &msg) { return {false, false, 0, msg}; }
   };
 
+  // assembled bytes, those in the bank window go to the bank selected by .BANK
+  struct OutputImage {
+    std::array<uint8_t, 0x10000> &memory;
+    const Core::BankLayout &layout;
+    std::map<int, std::vector<uint8_t>> banks;
+    int bank = 0;
+
+    // a location is the address, plus the bank number times $10000 for bytes of banks other than bank 0
+    int locate(uint16_t address) const { return bank != 0 && layout.contains(address) ? (bank << 16) | address : address; }
+    int next(int location) const;
+    uint8_t &at(int location);
+    uint8_t &operator[](uint16_t address) { return at(locate(address)); }
+  };
+
   struct LineParts {
     QString label;
     QString s_in;
@@ -104,6 +128,10 @@ private:
   static void validateValueRange(int32_t value, int32_t max, int assemblerLine);
 
   static LineParts disectLine(QString line, int assemblerLine);
+
+  static Core::AssemblyResult assembleLayout(Core::ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &Memory, const Core::AssemblyOptions &options);
+  static Core::AssemblyResult assemblePass(Core::ProcessorVersion processorVersion, const QString &code, std::array<uint8_t, 0x10000> &Memory, const Core::BankLayout &bankLayout, const std::set<int> &directLines,
+                                           DirectAddressingPassInfo &passInfo);
 };
 
 #endif // ASSEMBLER_H
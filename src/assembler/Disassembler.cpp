@@ -15,6 +15,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "src/assembler/Disassembler.h"
+#include "src/assembler/FlowAnalyzer.h"
+
+#include <set>
 using Core::AddressingMode;
 using Core::AssemblyMap;
 using Core::DisassemblyResult;
@@ -69,7 +72,7 @@ DisassemblyResult Disassembler::disassemble(ProcessorVersion ver, uint16_t begLo
   }
 
   code.append("\t.ORG $" + QString::number(begLoc, 16).toUpper() + "\n");
-  assemblyMap.addInstruction(begLoc, line++, 0, 0, 0, "ORG", "");
+  assemblyMap.addInstruction(-1, line++, 0, 0, 0, "ORG", "");
 
   for (uint16_t address = begLoc; address <= lastNonZero;) {
     uint8_t opCode = Memory[address];
@@ -120,46 +123,16 @@ DisassemblyResult Disassembler::disassemble(ProcessorVersion ver, uint16_t begLo
       continue;*/
     }
 
-    uint8_t operand1 = 0, operand2 = 0;
-    switch (inType) {
-    case AddressingMode::INH:
-      code.append("\t" + in + "\n");
-      break;
-    case AddressingMode::IMM:
-      operand1 = Memory[(address + 1) & 0xFFFF];
-      code.append("\t" + in + " #$" + QString::number(operand1, 16).toUpper() + "\n");
-      break;
-    case AddressingMode::IMMEXT:
-      operand1 = Memory[(address + 1) & 0xFFFF];
-      operand2 = Memory[(address + 2) & 0xFFFF];
-      code.append("\t" + in + " #$" + QString::number((operand1 << 8) | operand2, 16).toUpper() + "\n");
-      break;
-    case AddressingMode::DIR:
-      operand1 = Memory[(address + 1) & 0xFFFF];
-      code.append("\t" + in + " $" + QString::number(operand1, 16).toUpper() + "\n");
-      break;
-    case AddressingMode::IND:
-      operand1 = Memory[(address + 1) & 0xFFFF];
-      code.append("\t" + in + " $" + QString::number(operand1, 16).toUpper() + ",X\n");
-      break;
-    case AddressingMode::EXT:
-      operand1 = Memory[(address + 1) & 0xFFFF];
-      operand2 = Memory[(address + 2) & 0xFFFF];
-      code.append("\t" + in + " $" + QString::number((operand1 << 8) | operand2, 16).toUpper() + "\n");
-      break;
-    case AddressingMode::REL:
-      operand1 = Memory[(address + 1) & 0xFFFF];
-      if (operand1 == 0xFF || operand1 == 0xFE) {
-        code.append("\t" + in + " $00 ;Machine code addresses relative address " + QString::number(operand1, 16).toUpper() + "which is out of bounds\n");
-        messages.append(Msg{MsgType::WARN, "Machine code addresses relative address " + QString::number(operand1, 16).toUpper() + "which is out of bounds"});
-      } else {
-        code.append("\t" + in + " $" + QString::number(operand1, 16).toUpper() + "\n");
-      }
-      break;
-    case AddressingMode::INVALID: // this will never happen because of continue in previous check
-      break;
+    uint8_t operand1 = inSize > 1 ? Memory[(address + 1) & 0xFFFF] : 0;
+    uint8_t operand2 = inSize > 2 ? Memory[(address + 2) & 0xFFFF] : 0;
+    if (inType == AddressingMode::REL && (operand1 == 0xFF || operand1 == 0xFE)) {
+      code.append("\t" + in + " $00 ;Machine code addresses relative address " + QString::number(operand1, 16).toUpper() + "which is out of bounds\n");
+      messages.append(Msg{MsgType::WARN, "Machine code addresses relative address " + QString::number(operand1, 16).toUpper() + "which is out of bounds"});
+    } else {
+      code.append("\t" + decodeLine(ver, address, Memory).text + "\n");
     }
 
+    assemblyMap.addRange(address, inSize, line);
     assemblyMap.addInstruction(address, line++, opCode, operand1, operand2, in, "");
     if (static_cast<uint32_t>(address + inSize) >= 65536) {
       break;
@@ -168,3 +141,309 @@ DisassemblyResult Disassembler::disassemble(ProcessorVersion ver, uint16_t begLo
   }
   return DisassemblyResult{messages, code, assemblyMap};
 }
+
+/**
+ * @brief Decodes the instruction at an address without touching any other part of memory.
+ *
+ * @param ver The processor version to decode for.
+ * @param address Address of the first byte of the line.
+ * @param Memory The memory to decode from.
+ * @return The decoded instruction, or a .BYTE line if the byte is not an instruction.
+ */
+Disassembler::DecodedLine Disassembler::decodeLine(ProcessorVersion ver, uint16_t address, const std::array<uint8_t, 0x10000> &Memory) {
+  uint8_t opCode = Memory[address];
+  uint8_t operand1 = Memory[(address + 1) & 0xFFFF];
+  uint8_t operand2 = Memory[(address + 2) & 0xFFFF];
+  QString in = getInfoByOpCode(ver, opCode).mnemonic;
+
+  switch (getInstructionMode(ver, opCode)) {
+  case AddressingMode::INH:
+    return DecodedLine{address, 1, true, in, in};
+  case AddressingMode::IMM:
+    return DecodedLine{address, 2, true, in, in + " #$" + QString::number(operand1, 16).toUpper()};
+  case AddressingMode::IMMEXT:
+    return DecodedLine{address, 3, true, in, in + " #$" + QString::number((operand1 << 8) | operand2, 16).toUpper()};
+  case AddressingMode::DIR:
+    return DecodedLine{address, 2, true, in, in + " $" + QString::number(operand1, 16).toUpper()};
+  case AddressingMode::IND:
+    return DecodedLine{address, 2, true, in, in + " $" + QString::number(operand1, 16).toUpper() + ",X"};
+  case AddressingMode::EXT:
+    return DecodedLine{address, 3, true, in, in + " $" + QString::number((operand1 << 8) | operand2, 16).toUpper()};
+  case AddressingMode::REL:
+    return DecodedLine{address, 2, true, in, in + " $" + QString::number(operand1, 16).toUpper()};
+  case AddressingMode::INVALID:
+    break;
+  }
+  return DecodedLine{address, 1, false, QString(), ".BYTE $" + QString::number(opCode, 16).toUpper()};
+}
+
+/**
+ * @brief Decodes a window of consecutive lines starting at an address.
+ *
+ * Only the bytes covered by the returned lines are read, which lets views show live disassembly of
+ * their visible region. The window stops early at the end of memory.
+ *
+ * @param ver The processor version to decode for.
+ * @param begLoc Address of the first line.
+ * @param lineCount Maximum number of lines to decode.
+ * @param Memory The memory to decode from.
+ * @return The decoded lines in address order.
+ */
+std::vector<Disassembler::DecodedLine> Disassembler::decodeWindow(ProcessorVersion ver, uint16_t begLoc, int lineCount, const std::array<uint8_t, 0x10000> &Memory) {
+  std::vector<DecodedLine> lines;
+  lines.reserve(lineCount);
+  for (int address = begLoc; address <= 0xFFFF && static_cast<int>(lines.size()) < lineCount;) {
+    lines.push_back(decodeLine(ver, address, Memory));
+    address += lines.back().length;
+  }
+  return lines;
+}
+
+/**
+ * @brief Writes an address and byte listing of a memory range line by line to a stream.
+ *
+ * Nothing is collected in memory, so a dump of the whole address space costs no more than the
+ * stream's buffer. Runs of four or more zero bytes which are not instructions are written as a
+ * single .RMB line.
+ *
+ * @param ver The processor version to decode for.
+ * @param begLoc First address of the listing.
+ * @param endLoc Last address of the listing, inclusive.
+ * @param Memory The memory to decode from.
+ * @param out The stream to write to.
+ */
+void Disassembler::writeListing(ProcessorVersion ver, uint16_t begLoc, uint16_t endLoc, const std::array<uint8_t, 0x10000> &Memory, QTextStream &out) {
+  for (int address = begLoc; address <= endLoc;) {
+    int zeroCount = 0;
+    while (address + zeroCount <= endLoc && Memory[address + zeroCount] == 0) {
+      zeroCount++;
+    }
+    if (zeroCount >= 4) {
+      out << QString("%1").arg(address, 4, 16, QChar('0')).toUpper() << "  " << QString().leftJustified(10, ' ') << ".RMB " << zeroCount << "\n";
+      address += zeroCount;
+      continue;
+    }
+
+    DecodedLine line = decodeLine(ver, address, Memory);
+    QString bytes;
+    for (int i = 0; i < line.length; i++) {
+      bytes += QString("%1 ").arg(Memory[(address + i) & 0xFFFF], 2, 16, QChar('0')).toUpper();
+    }
+    out << QString("%1").arg(address, 4, 16, QChar('0')).toUpper() << "  " << bytes.leftJustified(10, ' ') << line.text << "\n";
+    address += line.length;
+  }
+}
+
+QString Disassembler::labelName(uint16_t address) {
+  return "L_" + QString("%1").arg(address, 4, 16, QChar('0')).toUpper();
+}
+
+/**
+ * @brief Formats the instruction at an address, using labels for traced branch and jump targets.
+ *
+ * An extended operand below $100 of an instruction which also has direct addressing would be
+ * reassembled as direct, even through a forward declared alias once direct addressing optimization
+ * is enabled, so such an instruction is written as its raw bytes with the instruction in a comment.
+ */
+QString Disassembler::tracedInstructionText(ProcessorVersion ver, uint16_t address, const std::array<uint8_t, 0x10000> &Memory, const std::bitset<0x10000> &labels) {
+  uint8_t opCode = Memory[address];
+  uint8_t operand1 = Memory[(address + 1) & 0xFFFF];
+  uint8_t operand2 = Memory[(address + 2) & 0xFFFF];
+  MnemonicInfo mnemonicInfo = getInfoByOpCode(ver, opCode);
+  QString in = mnemonicInfo.mnemonic;
+  uint16_t word = (operand1 << 8) | operand2;
+
+  switch (getInstructionMode(ver, opCode)) {
+  case AddressingMode::INH:
+    return in;
+  case AddressingMode::IMM:
+    return in + " #$" + QString::number(operand1, 16).toUpper();
+  case AddressingMode::IMMEXT:
+    return in + " #$" + QString::number(word, 16).toUpper();
+  case AddressingMode::DIR:
+    return in + " $" + QString::number(operand1, 16).toUpper();
+  case AddressingMode::IND:
+    return in + " $" + QString::number(operand1, 16).toUpper() + ",X";
+  case AddressingMode::EXT:
+    if (word <= 0xFF && mnemonicInfo.opCodes[Core::addressingModes[AddressingMode::DIR].id] != 0) {
+      return ".BYTE $" + QString::number(opCode, 16).toUpper() + ",$" + QString::number(operand1, 16).toUpper() + ",$" + QString::number(operand2, 16).toUpper() + "\t; " + in + " $" + QString("%1").arg(word, 4, 16, QChar('0')).toUpper();
+    }
+    if (FlowAnalyzer::isControlTransfer(ver, AssemblyMap::MappedInstr(address, -1, opCode, operand1, operand2, in, "")) && labels[word]) {
+      return in + " " + labelName(word);
+    }
+    return in + " $" + QString::number(word, 16).toUpper();
+  case AddressingMode::REL: {
+    uint16_t target = (address + 2 + static_cast<int8_t>(operand1)) & 0xFFFF;
+    if (labels[target]) {
+      return in + " " + labelName(target);
+    }
+    return in + " $" + QString::number(operand1, 16).toUpper();
+  }
+  case AddressingMode::INVALID:
+    break;
+  }
+  return QString();
+}
+
+/**
+ * @brief Disassembles memory by following the control flow from its entry points.
+ *
+ * Tracing starts at the reset vector, every interrupt vector which is set and the given entry
+ * points. Branches, jumps and calls are followed, while RTS, RTI, BRA, JMP and unknown opcodes end
+ * a path. Each address is decoded at most once, so the work is linear in the size of memory.
+ * Bytes reached as code are listed as instructions, branch and jump targets get L_XXXX labels,
+ * and every other nonzero byte is listed as .BYTE data. The vectors are written last with .SETW,
+ * because every .ORG overwrites the reset vector.
+ *
+ * @param ver The processor version to decode for.
+ * @param entryPoints Additional addresses known to contain code.
+ * @param Memory The memory to disassemble.
+ * @return The listing, its assembly map and warnings about paths that could not be followed.
+ */
+DisassemblyResult Disassembler::disassembleTraced(ProcessorVersion ver, const std::vector<uint16_t> &entryPoints, const std::array<uint8_t, 0x10000> &Memory) {
+  static const std::set<QString> endsPath = {"BRA", "JMP", "RTS", "RTI"};
+  static const std::array<std::pair<uint16_t, const char *>, 4> vectors = {{{0xFFF8, "IRQ_PTR"}, {0xFFFA, "SWI_PTR"}, {0xFFFC, "NMI_PTR"}, {0xFFFE, "RST_PTR"}}};
+
+  QString code;
+  AssemblyMap assemblyMap;
+  QList<Msg> messages;
+
+  std::bitset<0x10000> instructionStart;
+  std::bitset<0x10000> isCode;
+  std::bitset<0x10000> isTarget;
+  std::vector<uint16_t> pending(entryPoints.rbegin(), entryPoints.rend());
+  for (const auto &[vector, name] : vectors) {
+    uint16_t value = (Memory[vector] << 8) | Memory[vector + 1];
+    if (value != 0 || (vector == 0xFFFE && Memory[0] != 0)) {
+      pending.push_back(value);
+      isTarget[value] = true;
+    }
+  }
+  for (uint16_t entry : entryPoints) {
+    isTarget[entry] = true;
+  }
+
+  while (!pending.empty()) {
+    uint16_t address = pending.back();
+    pending.pop_back();
+    while (!instructionStart[address]) {
+      QString location = "$" + QString::number(address, 16).toUpper();
+      if (isCode[address]) {
+        messages.append(Msg{MsgType::WARN, "Control flow reaches the middle of an instruction at address: " + location});
+        break;
+      }
+      uint8_t opCode = Memory[address];
+      if (getInstructionMode(ver, opCode) == AddressingMode::INVALID || !Core::getInstructionSupported(ver, opCode)) {
+        messages.append(Msg{MsgType::WARN, "Control flow reaches unknown/unsupported instruction at address: " + location});
+        break;
+      }
+      int length = getInstructionLength(ver, opCode);
+      if (address + length > 0x10000) {
+        messages.append(Msg{MsgType::WARN, "Instruction at address " + location + " runs past the end of memory"});
+        break;
+      }
+      bool overlaps = false;
+      for (int i = 1; i < length; i++) {
+        overlaps |= isCode[address + i];
+      }
+      if (overlaps) {
+        messages.append(Msg{MsgType::WARN, "Instruction at address " + location + " overlaps another instruction"});
+        break;
+      }
+      instructionStart[address] = true;
+      for (int i = 0; i < length; i++) {
+        isCode[address + i] = true;
+      }
+
+      AssemblyMap::MappedInstr instruction(address, -1, opCode, Memory[(address + 1) & 0xFFFF], Memory[(address + 2) & 0xFFFF], getInfoByOpCode(ver, opCode).mnemonic, "");
+      int target = FlowAnalyzer::transferTarget(ver, instruction);
+      if (target != -1) {
+        isTarget[target] = true;
+        pending.push_back(target);
+      }
+      if (endsPath.count(instruction.IN) != 0 || address + length == 0x10000) {
+        break;
+      }
+      address += length;
+    }
+  }
+
+  std::bitset<0x10000> labels = isTarget & instructionStart;
+  int line = 0;
+  int instructionCount = 0;
+  int dataBytes = 0;
+  bool needOrg = true;
+  auto zeroRun = [&](int from) {
+    int count = 0;
+    while (from + count < Core::ioRegistersStart && Memory[from + count] == 0 && !instructionStart[from + count]) {
+      count++;
+    }
+    return count;
+  };
+  for (int address = 0; address < Core::ioRegistersStart;) {
+    if (instructionStart[address]) {
+      if (needOrg) {
+        code.append("\t.ORG $" + QString::number(address, 16).toUpper() + "\n");
+        assemblyMap.addInstruction(-1, line++, 0, 0, 0, "ORG", "");
+        needOrg = false;
+      }
+      uint8_t opCode = Memory[address];
+      code.append((labels[address] ? labelName(address) : QString()) + "\t" + tracedInstructionText(ver, address, Memory, labels) + "\n");
+      assemblyMap.addRange(address, getInstructionLength(ver, opCode), line);
+      assemblyMap.addInstruction(address, line++, opCode, Memory[(address + 1) & 0xFFFF], Memory[(address + 2) & 0xFFFF], getInfoByOpCode(ver, opCode).mnemonic, "");
+      instructionCount++;
+      address += getInstructionLength(ver, opCode);
+      continue;
+    }
+
+    // zero runs of four or more bytes are left to the cleared memory, shorter ones stay in the data
+    int zeroCount = zeroRun(address);
+    if (zeroCount >= 4 || address + zeroCount == Core::ioRegistersStart) {
+      address += zeroCount;
+      needOrg = true;
+      continue;
+    }
+
+    if (needOrg) {
+      code.append("\t.ORG $" + QString::number(address, 16).toUpper() + "\n");
+      assemblyMap.addInstruction(-1, line++, 0, 0, 0, "ORG", "");
+      needOrg = false;
+    }
+    QStringList bytes;
+    int start = address;
+    while (bytes.size() < 8 && address < Core::ioRegistersStart && !instructionStart[address]) {
+      if (Memory[address] == 0 && !bytes.isEmpty()) {
+        zeroCount = zeroRun(address);
+        if (zeroCount >= 4 || address + zeroCount == Core::ioRegistersStart) {
+          break;
+        }
+      }
+      bytes.append("$" + QString::number(Memory[address], 16).toUpper());
+      address++;
+    }
+    code.append("\t.BYTE " + bytes.join(",") + "\n");
+    assemblyMap.addRange(start, bytes.size(), line);
+    assemblyMap.addInstruction(start, line++, 0, 0, 0, "BYTE", "");
+    dataBytes += bytes.size();
+  }
+
+  for (uint16_t i = Core::ioRegistersStart; i != 0; i += 2) {
+    uint16_t value = (Memory[i] << 8) | Memory[i + 1];
+    if (value == 0 && i != 0xFFFE) {
+      continue;
+    }
+    QString location = "$" + QString::number(i, 16).toUpper();
+    QString target = labels[value] ? labelName(value) : "$" + QString::number(value, 16).toUpper();
+    for (const auto &[vector, name] : vectors) {
+      if (vector == i) {
+        location = name;
+      }
+    }
+    code.append("\t.SETW " + location + "," + target + "\n");
+    assemblyMap.addRange(i, 2, line);
+    assemblyMap.addInstruction(i, line++, 0, 0, 0, "SETW", "");
+  }
+
+  messages.append(Msg{MsgType::NONE, "Traced " + QString::number(instructionCount) + " instructions, " + QString::number(dataBytes) + " bytes listed as data"});
+  return DisassemblyResult{messages, code, assemblyMap};
+}
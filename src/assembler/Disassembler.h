@@ -19,11 +19,32 @@
 
 #include "src/core/Core.h"
 
+#include <QString>
+#include <QTextStream>
+
 #include <array>
+#include <bitset>
 #include <stdint.h>
+#include <vector>
 class Disassembler {
 public:
+  struct DecodedLine {
+    uint16_t address;
+    uint8_t length; // bytes covered by the line, 1 for a byte which is not an instruction
+    bool valid;
+    QString mnemonic;
+    QString text;
+  };
+
+  static DecodedLine decodeLine(Core::ProcessorVersion ver, uint16_t address, const std::array<uint8_t, 0x10000> &Memory);
+  static std::vector<DecodedLine> decodeWindow(Core::ProcessorVersion ver, uint16_t begLoc, int lineCount, const std::array<uint8_t, 0x10000> &Memory);
+  static void writeListing(Core::ProcessorVersion ver, uint16_t begLoc, uint16_t endLoc, const std::array<uint8_t, 0x10000> &Memory, QTextStream &out);
   static Core::DisassemblyResult disassemble(Core::ProcessorVersion ver, uint16_t begLoc, uint16_t endLoc, std::array<uint8_t, 0x10000> &Memory);
+  static Core::DisassemblyResult disassembleTraced(Core::ProcessorVersion ver, const std::vector<uint16_t> &entryPoints, const std::array<uint8_t, 0x10000> &Memory);
+
+private:
+  static QString labelName(uint16_t address);
+  static QString tracedInstructionText(Core::ProcessorVersion ver, uint16_t address, const std::array<uint8_t, 0x10000> &Memory, const std::bitset<0x10000> &labels);
 };
 
 #endif // DISASSEMBLER_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/assembler/DisassemblyCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+using Core::ProcessorVersion;
+
+/**
+ * @brief Drops the cached lines of every page in a range whose contents changed.
+ *
+ * Each page keeps a copy of its bytes and of the two bytes after it, which an instruction at the
+ * end of the page reads. A page is only decoded again when the program wrote to one of them, so a
+ * live view costs one comparison per visible page and frame while the code stays the same.
+ *
+ * @param ver The processor version to decode for. Changing it drops the whole cache.
+ * @param begLoc First address about to be decoded.
+ * @param length Number of bytes about to be decoded.
+ * @param Memory The memory the lines will be decoded from.
+ */
+void DisassemblyCache::sync(ProcessorVersion ver, uint16_t begLoc, int length, const std::array<uint8_t, 0x10000> &Memory) {
+  if (ver != processorVersion) {
+    clear();
+    processorVersion = ver;
+  }
+  int firstPage = begLoc / pageSize;
+  int lastPage = std::min(begLoc + std::max(length, 1) - 1, 0xFFFF) / pageSize;
+  for (int pageIndex = firstPage; pageIndex <= lastPage; pageIndex++) {
+    if (pages[pageIndex] && !contentsMatch(*pages[pageIndex], pageIndex, Memory)) {
+      loadPage(pageIndex, Memory);
+    }
+  }
+}
+
+/**
+ * @brief Returns the decoded line at an address, decoding it on first use.
+ *
+ * The page of the address has to be synced with the memory first, see sync().
+ */
+const Disassembler::DecodedLine &DisassemblyCache::decodeLine(uint16_t address, const std::array<uint8_t, 0x10000> &Memory) {
+  int pageIndex = address / pageSize;
+  if (!pages[pageIndex]) {
+    loadPage(pageIndex, Memory);
+  }
+  Page &page = *pages[pageIndex];
+  int offset = address % pageSize;
+  if (!page.decoded[offset]) {
+    page.lines[offset] = Disassembler::decodeLine(processorVersion, address, Memory);
+    page.decoded[offset] = true;
+  }
+  return page.lines[offset];
+}
+
+void DisassemblyCache::clear() {
+  for (std::unique_ptr<Page> &page : pages) {
+    page.reset();
+  }
+}
+
+bool DisassemblyCache::contentsMatch(const Page &page, int pageIndex, const std::array<uint8_t, 0x10000> &Memory) {
+  int begLoc = pageIndex * pageSize;
+  if (begLoc + pageSize + pageOverlap <= 0x10000) {
+    return std::memcmp(page.contents.data(), Memory.data() + begLoc, page.contents.size()) == 0;
+  }
+  for (size_t i = 0; i < page.contents.size(); i++) {
+    if (page.contents[i] != Memory[(begLoc + i) & 0xFFFF]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DisassemblyCache::loadPage(int pageIndex, const std::array<uint8_t, 0x10000> &Memory) {
+  if (!pages[pageIndex]) {
+    pages[pageIndex] = std::make_unique<Page>();
+  }
+  Page &page = *pages[pageIndex];
+  int begLoc = pageIndex * pageSize;
+  for (size_t i = 0; i < page.contents.size(); i++) {
+    page.contents[i] = Memory[(begLoc + i) & 0xFFFF];
+  }
+  page.decoded.reset();
+}
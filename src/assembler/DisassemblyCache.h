@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DISASSEMBLYCACHE_H
+#define DISASSEMBLYCACHE_H
+
+#include "src/assembler/Disassembler.h"
+#include "src/core/Core.h"
+
+#include <array>
+#include <bitset>
+#include <memory>
+#include <stdint.h>
+
+class DisassemblyCache {
+public:
+  void sync(Core::ProcessorVersion ver, uint16_t begLoc, int length, const std::array<uint8_t, 0x10000> &Memory);
+  const Disassembler::DecodedLine &decodeLine(uint16_t address, const std::array<uint8_t, 0x10000> &Memory);
+  void clear();
+
+private:
+  static constexpr int pageSize = 0x100;
+  static constexpr int pageOverlap = 2; // bytes of the next page read by an instruction starting at the end of a page
+
+  struct Page {
+    std::array<uint8_t, pageSize + pageOverlap> contents;
+    std::bitset<pageSize> decoded;
+    std::array<Disassembler::DecodedLine, pageSize> lines;
+  };
+
+  static bool contentsMatch(const Page &page, int pageIndex, const std::array<uint8_t, 0x10000> &Memory);
+  void loadPage(int pageIndex, const std::array<uint8_t, 0x10000> &Memory);
+
+  Core::ProcessorVersion processorVersion = Core::ProcessorVersion::M6800;
+  std::array<std::unique_ptr<Page>, 0x10000 / pageSize> pages;
+};
+
+#endif // DISASSEMBLYCACHE_H
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/assembler/FlowAnalyzer.h"
+
+#include <algorithm>
+#include <climits>
+#include <map>
+
+using Core::AddressingMode;
+using Core::AssemblyMap;
+using Core::Msg;
+using Core::MsgType;
+using Core::ProcessorVersion;
+
+bool FlowAnalyzer::isInstruction(const MappedInstr &instruction) {
+  return instruction.address != -1 && !instruction.IN.isEmpty() && instruction.IN[0] != '.';
+}
+
+bool FlowAnalyzer::isControlTransfer(ProcessorVersion processorVersion, const MappedInstr &instruction) {
+  if (Core::getInstructionMode(processorVersion, instruction.byte1) == AddressingMode::REL) {
+    return true;
+  }
+  static const std::set<QString> transfers = {"JMP", "JSR", "RTS", "RTI", "SWI", "WAI"};
+  return transfers.count(Core::getInfoByOpCode(processorVersion, instruction.byte1).mnemonic) != 0;
+}
+
+int FlowAnalyzer::operandAddress(ProcessorVersion processorVersion, const MappedInstr &instruction) {
+  switch (Core::getInstructionMode(processorVersion, instruction.byte1)) {
+  case AddressingMode::DIR:
+    return instruction.byte2;
+  case AddressingMode::EXT:
+    return (instruction.byte2 << 8) | instruction.byte3;
+  default:
+    return -1;
+  }
+}
+
+/**
+ * @brief Returns the address a branch, jump or call transfers control to.
+ *
+ * @return The target address, or -1 if the instruction does not transfer control or the target
+ * depends on the index register.
+ */
+int FlowAnalyzer::transferTarget(ProcessorVersion processorVersion, const MappedInstr &instruction) {
+  if (Core::getInstructionMode(processorVersion, instruction.byte1) == AddressingMode::REL) {
+    return (instruction.address + 2 + static_cast<int8_t>(instruction.byte2)) & 0xFFFF;
+  }
+  if (isControlTransfer(processorVersion, instruction)) {
+    return operandAddress(processorVersion, instruction);
+  }
+  return -1;
+}
+
+/**
+ * @brief Splits assembled code into basic blocks and finds its natural loops.
+ *
+ * A block starts at the first instruction, at every branch or jump target, after every control
+ * transfer and after every gap in the code. Calls (JSR, BSR) and SWI continue with the next
+ * instruction, their callee is not part of the block. Blocks which cannot be reached from
+ * another block are treated as entry points, which covers the reset and interrupt handlers.
+ *
+ * @param processorVersion The version of the processor the code was assembled for.
+ * @param assemblyMap Assembly map of the assembled code.
+ * @return The blocks with their cycle counts and the loops with their cycle counts per iteration.
+ */
+FlowAnalyzer::ControlFlowGraph FlowAnalyzer::buildGraph(ProcessorVersion processorVersion, const AssemblyMap &assemblyMap) {
+  ControlFlowGraph graph;
+  for (const MappedInstr &instruction : assemblyMap.getInstructions()) {
+    if (isInstruction(instruction) && Core::getInstructionSupported(processorVersion, instruction.byte1)) {
+      graph.instructions.push_back(instruction);
+    }
+  }
+  const std::vector<MappedInstr> &instructions = graph.instructions;
+  if (instructions.empty()) {
+    return graph;
+  }
+
+  std::map<int, size_t> indexByAddress;
+  for (size_t i = 0; i < instructions.size(); i++) {
+    indexByAddress[instructions[i].address] = i;
+  }
+  auto fallsThrough = [&](size_t i) {
+    return i + 1 < instructions.size() && instructions[i + 1].address == instructions[i].address + Core::getInstructionLength(processorVersion, instructions[i].byte1);
+  };
+
+  std::set<size_t> leaders = {0};
+  for (size_t i = 0; i < instructions.size(); i++) {
+    auto target = indexByAddress.find(transferTarget(processorVersion, instructions[i]));
+    if (target != indexByAddress.end()) {
+      leaders.insert(target->second);
+    }
+    if (isControlTransfer(processorVersion, instructions[i]) || !fallsThrough(i)) {
+      leaders.insert(i + 1);
+    }
+  }
+
+  std::vector<int> blockOfInstruction(instructions.size());
+  for (size_t i = 0; i < instructions.size(); i++) {
+    if (leaders.count(i) != 0) {
+      graph.blocks.push_back(BasicBlock{i, i, 0, {}, {}});
+    }
+    BasicBlock &block = graph.blocks.back();
+    block.lastInstruction = i;
+    block.cycles += Core::getInstructionCycleCount(processorVersion, instructions[i].byte1);
+    blockOfInstruction[i] = static_cast<int>(graph.blocks.size()) - 1;
+  }
+
+  static const std::set<QString> noFallThrough = {"BRA", "JMP", "RTS", "RTI"};
+  static const std::set<QString> noTargetEdge = {"BSR", "BRN", "JSR"};
+  for (size_t b = 0; b < graph.blocks.size(); b++) {
+    BasicBlock &block = graph.blocks[b];
+    const MappedInstr &last = instructions[block.lastInstruction];
+    const QString mnemonic = Core::getInfoByOpCode(processorVersion, last.byte1).mnemonic;
+    std::set<int> successors;
+    if (fallsThrough(block.lastInstruction) && noFallThrough.count(mnemonic) == 0) {
+      successors.insert(blockOfInstruction[block.lastInstruction + 1]);
+    }
+    auto target = indexByAddress.find(transferTarget(processorVersion, last));
+    if (target != indexByAddress.end() && noTargetEdge.count(mnemonic) == 0) {
+      successors.insert(blockOfInstruction[target->second]);
+    }
+    block.successors.assign(successors.begin(), successors.end());
+    for (int successor : successors) {
+      graph.blocks[successor].predecessors.push_back(static_cast<int>(b));
+    }
+  }
+
+  findLoops(graph, computeDominators(graph.blocks));
+  return graph;
+}
+
+/**
+ * @brief Computes the immediate dominator of every block.
+ *
+ * Uses the iterative algorithm of Cooper, Harvey and Kennedy over a virtual root placed after the
+ * last block. The root precedes the first block, every block without predecessors and, until
+ * every block is reachable, the first unreachable block.
+ *
+ * @return Immediate dominator of each block, the virtual root has index blocks.size().
+ */
+std::vector<int> FlowAnalyzer::computeDominators(const std::vector<BasicBlock> &blocks) {
+  const int root = static_cast<int>(blocks.size());
+  std::vector<bool> isEntry(blocks.size(), false);
+  std::vector<bool> reached(blocks.size(), false);
+  auto reach = [&](int entry) {
+    isEntry[entry] = true;
+    std::vector<int> stack = {entry};
+    while (!stack.empty()) {
+      int block = stack.back();
+      stack.pop_back();
+      if (reached[block]) {
+        continue;
+      }
+      reached[block] = true;
+      for (int successor : blocks[block].successors) {
+        stack.push_back(successor);
+      }
+    }
+  };
+  for (size_t b = 0; b < blocks.size(); b++) {
+    if (b == 0 || blocks[b].predecessors.empty()) {
+      reach(static_cast<int>(b));
+    }
+  }
+  for (size_t b = 0; b < blocks.size(); b++) {
+    if (!reached[b]) {
+      reach(static_cast<int>(b));
+    }
+  }
+
+  // Postorder numbering from the virtual root
+  std::vector<int> postOrder(blocks.size() + 1, -1);
+  std::vector<int> reversePostOrder;
+  std::vector<bool> visited(blocks.size(), false);
+  int counter = 0;
+  for (size_t entry = 0; entry < blocks.size(); entry++) {
+    if (!isEntry[entry] || visited[entry]) {
+      continue;
+    }
+    std::vector<std::pair<int, size_t>> stack = {{static_cast<int>(entry), 0}};
+    visited[entry] = true;
+    while (!stack.empty()) {
+      auto &[block, next] = stack.back();
+      if (next < blocks[block].successors.size()) {
+        int successor = blocks[block].successors[next++];
+        if (!visited[successor]) {
+          visited[successor] = true;
+          stack.push_back({successor, 0});
+        }
+      } else {
+        postOrder[block] = counter++;
+        reversePostOrder.push_back(block);
+        stack.pop_back();
+      }
+    }
+  }
+  postOrder[root] = counter;
+  std::reverse(reversePostOrder.begin(), reversePostOrder.end());
+
+  std::vector<int> idom(blocks.size() + 1, -1);
+  idom[root] = root;
+  auto intersect = [&](int a, int b) {
+    while (a != b) {
+      while (postOrder[a] < postOrder[b]) {
+        a = idom[a];
+      }
+      while (postOrder[b] < postOrder[a]) {
+        b = idom[b];
+      }
+    }
+    return a;
+  };
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int block : reversePostOrder) {
+      int newIdom = isEntry[block] ? root : -1;
+      for (int predecessor : blocks[block].predecessors) {
+        if (idom[predecessor] == -1) {
+          continue;
+        }
+        newIdom = newIdom == -1 ? predecessor : intersect(predecessor, newIdom);
+      }
+      if (idom[block] != newIdom) {
+        idom[block] = newIdom;
+        changed = true;
+      }
+    }
+  }
+  return idom;
+}
+
+bool FlowAnalyzer::dominates(const std::vector<int> &idom, int dominator, int block) {
+  const int root = static_cast<int>(idom.size()) - 1;
+  while (block != root) {
+    if (block == dominator) {
+      return true;
+    }
+    block = idom[block];
+  }
+  return false;
+}
+
+/**
+ * @brief Finds natural loops from back edges, an edge whose target dominates its source.
+ *
+ * Back edges to the same header are merged into one loop.
+ */
+void FlowAnalyzer::findLoops(ControlFlowGraph &graph, const std::vector<int> &idom) {
+  std::map<int, std::set<int>> bodies;
+  for (size_t b = 0; b < graph.blocks.size(); b++) {
+    for (int successor : graph.blocks[b].successors) {
+      if (!dominates(idom, successor, static_cast<int>(b))) {
+        continue;
+      }
+      std::set<int> &body = bodies[successor];
+      body.insert(successor);
+      std::vector<int> stack = {static_cast<int>(b)};
+      while (!stack.empty()) {
+        int block = stack.back();
+        stack.pop_back();
+        if (!body.insert(block).second) {
+          continue;
+        }
+        for (int predecessor : graph.blocks[block].predecessors) {
+          stack.push_back(predecessor);
+        }
+      }
+    }
+  }
+  for (auto &[header, body] : bodies) {
+    Loop loop{header, body, 0, 0};
+    measureLoop(graph, loop, idom);
+    graph.loops.push_back(loop);
+  }
+}
+
+/**
+ * @brief Computes the shortest and the longest path of one loop iteration.
+ *
+ * An iteration starts at the header and ends with a back edge to the header. Back edges of inner
+ * loops are ignored, so every inner loop contributes a single pass through its body.
+ */
+void FlowAnalyzer::measureLoop(const ControlFlowGraph &graph, Loop &loop, const std::vector<int> &idom) {
+  auto isForwardEdge = [&](int from, int to) {
+    return loop.blocks.count(to) != 0 && !dominates(idom, to, from);
+  };
+
+  // Topological order of the body without back edges
+  std::vector<int> order;
+  std::set<int> visited;
+  std::vector<std::pair<int, size_t>> stack = {{loop.header, 0}};
+  visited.insert(loop.header);
+  while (!stack.empty()) {
+    auto &[block, next] = stack.back();
+    const std::vector<int> &successors = graph.blocks[block].successors;
+    if (next < successors.size()) {
+      int successor = successors[next++];
+      if (isForwardEdge(block, successor) && visited.insert(successor).second) {
+        stack.push_back({successor, 0});
+      }
+    } else {
+      order.push_back(block);
+      stack.pop_back();
+    }
+  }
+  std::reverse(order.begin(), order.end());
+
+  std::map<int, int> shortest;
+  std::map<int, int> longest;
+  shortest[loop.header] = longest[loop.header] = graph.blocks[loop.header].cycles;
+  int minCycles = INT_MAX;
+  int maxCycles = 0;
+  for (int block : order) {
+    for (int successor : graph.blocks[block].successors) {
+      if (successor == loop.header) {
+        minCycles = std::min(minCycles, shortest[block]);
+        maxCycles = std::max(maxCycles, longest[block]);
+      } else if (isForwardEdge(block, successor)) {
+        const int cycles = graph.blocks[successor].cycles;
+        shortest[successor] = shortest.count(successor) != 0 ? std::min(shortest[successor], shortest[block] + cycles) : shortest[block] + cycles;
+        longest[successor] = std::max(longest[successor], longest[block] + cycles);
+      }
+    }
+  }
+  loop.minIterationCycles = minCycles == INT_MAX ? 0 : minCycles;
+  loop.maxIterationCycles = maxCycles;
+}
+
+/**
+ * @brief Describes the blocks and loops of a control flow graph as console messages.
+ */
+QList<Msg> FlowAnalyzer::describeGraph(const ControlFlowGraph &graph) {
+  QList<Msg> messages;
+  auto lineOf = [&](int block) { return graph.instructions[graph.blocks[block].firstInstruction].lineNumber; };
+  auto addressOf = [&](int block) { return QString("$%1").arg(graph.instructions[graph.blocks[block].firstInstruction].address, 4, 16, QChar('0')).toUpper(); };
+
+  messages.append(Msg{MsgType::NONE, QString("Control flow: %1 basic block(s), %2 natural loop(s)").arg(graph.blocks.size()).arg(graph.loops.size())});
+  for (size_t b = 0; b < graph.blocks.size(); b++) {
+    const BasicBlock &block = graph.blocks[b];
+    messages.append(Msg{MsgType::NONE,
+                        QString("Block %1 (lines %2-%3): %4 cycle(s)")
+                            .arg(addressOf(static_cast<int>(b)))
+                            .arg(lineOf(static_cast<int>(b)))
+                            .arg(graph.instructions[block.lastInstruction].lineNumber)
+                            .arg(block.cycles)});
+  }
+  for (const Loop &loop : graph.loops) {
+    QString cycles = QString::number(loop.maxIterationCycles);
+    if (loop.minIterationCycles != loop.maxIterationCycles) {
+      cycles = QString("%1-%2").arg(loop.minIterationCycles).arg(loop.maxIterationCycles);
+    }
+    messages.append(Msg{MsgType::NONE, QString("Loop at %1 (line %2, %3 block(s)): %4 cycle(s) per iteration").arg(addressOf(loop.header)).arg(lineOf(loop.header)).arg(loop.blocks.size()).arg(cycles)});
+  }
+  return messages;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FLOWANALYZER_H
+#define FLOWANALYZER_H
+
+#include "src/core/Core.h"
+
+#include <QList>
+#include <QString>
+
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+class FlowAnalyzer {
+public:
+  using MappedInstr = Core::AssemblyMap::MappedInstr;
+
+  struct BasicBlock {
+    size_t firstInstruction; // index into AssemblyMap::getInstructions()
+    size_t lastInstruction;
+    int cycles;
+    std::vector<int> successors;
+    std::vector<int> predecessors;
+  };
+  struct Loop {
+    int header;
+    std::set<int> blocks;
+    int minIterationCycles; // shortest path through the body, inner loops counted once
+    int maxIterationCycles; // longest path through the body, inner loops counted once
+  };
+  struct ControlFlowGraph {
+    std::vector<MappedInstr> instructions;
+    std::vector<BasicBlock> blocks;
+    std::vector<Loop> loops;
+  };
+
+  static ControlFlowGraph buildGraph(Core::ProcessorVersion processorVersion, const Core::AssemblyMap &assemblyMap);
+  static QList<Core::Msg> describeGraph(const ControlFlowGraph &graph);
+
+  static bool isInstruction(const MappedInstr &instruction);
+  static bool isControlTransfer(Core::ProcessorVersion processorVersion, const MappedInstr &instruction);
+  static int operandAddress(Core::ProcessorVersion processorVersion, const MappedInstr &instruction);
+  static int transferTarget(Core::ProcessorVersion processorVersion, const MappedInstr &instruction);
+
+private:
+  static std::vector<int> computeDominators(const std::vector<BasicBlock> &blocks);
+  static bool dominates(const std::vector<int> &idom, int dominator, int block);
+  static void findLoops(ControlFlowGraph &graph, const std::vector<int> &idom);
+  static void measureLoop(const ControlFlowGraph &graph, Loop &loop, const std::vector<int> &idom);
+};
+
+#endif // FLOWANALYZER_H
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/assembler/Optimizer.h"
+#include "src/assembler/FlowAnalyzer.h"
+
+#include <map>
+
+using Core::AddressingMode;
+using Core::AssemblyMap;
+using Core::Flag;
+using Core::MnemonicInfo;
+using Core::Msg;
+using Core::MsgType;
+using Core::ProcessorVersion;
+
+namespace {
+  // Store mnemonic -> load mnemonic of the same register and the register width in bytes
+  const std::map<QString, std::pair<QString, int>> storeLoadPairs = {
+      {"STAA", {"LDAA", 1}},
+      {"STAB", {"LDAB", 1}},
+      {"STD", {"LDD", 2}},
+      {"STS", {"LDS", 2}},
+      {"STX", {"LDX", 2}},
+  };
+  // Pairs of adjacent instructions which cancel each other out
+  const std::map<QString, QString> cancellingPairs = {
+      {"INX", "DEX"},
+      {"DEX", "INX"},
+      {"INS", "DES"},
+      {"DES", "INS"},
+  };
+  const std::set<QString> carryReaders = {"ADCA", "ADCB", "SBCA", "SBCB", "ROL", "ROLA", "ROLB", "ROR", "RORA", "RORB", "BCC", "BCS", "BHI", "BLS", "DAA", "TPA"};
+  const std::set<QString> zeroReaders = {"BEQ", "BNE", "BGT", "BLE", "BHI", "BLS", "TPA"};
+
+  // Position of the flag in the "HINZVC" string of MnemonicInfo::flags
+  int flagColumn(Flag flag) {
+    return 5 - static_cast<int>(flag);
+  }
+} // namespace
+
+bool Optimizer::isLabeledLine(const QStringList &lines, int lineNumber) {
+  if (lineNumber < 0 || lineNumber >= lines.size() || lines[lineNumber].isEmpty()) {
+    return false;
+  }
+  return lines[lineNumber][0].isLetter();
+}
+
+QString Optimizer::labelOf(const QStringList &lines, int lineNumber) {
+  if (!isLabeledLine(lines, lineNumber)) {
+    return "";
+  }
+  const QString &line = lines[lineNumber];
+  qsizetype labelEnd = 0;
+  while (labelEnd < line.size() && line[labelEnd] != ' ' && line[labelEnd] != '\t') {
+    labelEnd++;
+  }
+  return line.left(labelEnd);
+}
+
+QString Optimizer::sourceInstruction(const QStringList &lines, int lineNumber) {
+  const QString line = lines[lineNumber].split(';')[0];
+  return line.mid(labelOf(lines, lineNumber).size()).simplified();
+}
+
+/**
+ * @brief Finds the instruction executed after the instruction at the given index, without a jump.
+ *
+ * Entries without a location (.EQU, .ORG, .RMB) are skipped, any located directive or
+ * address gap ends the straight-line code.
+ *
+ * @return Index of the next instruction, or -1 if the code does not continue.
+ */
+int Optimizer::followingInstruction(ProcessorVersion processorVersion, const std::vector<MappedInstr> &instructions, size_t index) {
+  const int nextAddress = instructions[index].address + Core::getInstructionLength(processorVersion, instructions[index].byte1);
+  for (size_t i = index + 1; i < instructions.size(); i++) {
+    if (instructions[i].address == -1) {
+      continue;
+    }
+    if (instructions[i].address != nextAddress || !FlowAnalyzer::isInstruction(instructions[i])) {
+      return -1;
+    }
+    return static_cast<int>(i);
+  }
+  return -1;
+}
+
+std::set<int> Optimizer::collectControlTargets(ProcessorVersion processorVersion, const std::vector<MappedInstr> &instructions) {
+  std::set<int> targets;
+  for (const MappedInstr &instruction : instructions) {
+    if (FlowAnalyzer::isInstruction(instruction) && FlowAnalyzer::transferTarget(processorVersion, instruction) != -1) {
+      targets.insert(FlowAnalyzer::transferTarget(processorVersion, instruction));
+    }
+  }
+  return targets;
+}
+
+/**
+ * @brief Checks whether a flag is overwritten before it is read, following the code after an instruction.
+ *
+ * The check is conservative: reaching a label, a branch target, a control transfer or the end of
+ * the straight-line code treats the flag as live.
+ *
+ * @param index Index of the instruction whose result flag is being checked.
+ * @return True if no instruction can observe the value of the flag left by the instruction.
+ */
+bool Optimizer::isFlagDead(ProcessorVersion processorVersion, const std::vector<MappedInstr> &instructions, size_t index, Flag flag, const QStringList &lines, const std::set<int> &controlTargets) {
+  const std::set<QString> &readers = flag == Flag::Carry ? carryReaders : zeroReaders;
+  int next = followingInstruction(processorVersion, instructions, index);
+  while (next != -1) {
+    const MappedInstr &instruction = instructions[next];
+    if (isLabeledLine(lines, instruction.lineNumber) || controlTargets.count(instruction.address) != 0) {
+      return false;
+    }
+    const MnemonicInfo info = Core::getInfoByOpCode(processorVersion, instruction.byte1);
+    if (readers.count(info.mnemonic) != 0 || FlowAnalyzer::isControlTransfer(processorVersion, instruction)) {
+      return false;
+    }
+    if (info.flags[flagColumn(flag)] != '-') {
+      return true;
+    }
+    next = followingInstruction(processorVersion, instructions, next);
+  }
+  return false;
+}
+
+/**
+ * @brief Finds peephole rewrites in assembled code.
+ *
+ * Every rewrite replaces a source line with an equivalent one, or with an empty line when the
+ * instruction is removed, so the line numbers of the source stay unchanged. The rewrites are:
+ * - a load directly after a store of the same register to the same address is removed,
+ *   the store already sets the same N, Z and V flags.
+ * - LDAA #0 and LDAB #0 become CLRA and CLRB when the carry flag is overwritten before it is read.
+ * - adjacent INX/DEX and INS/DES pairs are removed, for INX/DEX only if the zero flag is dead.
+ *
+ * Lines with a label or targeted by a branch or jump are never removed. Loads from the input
+ * registers are never removed because their value changes between reads.
+ *
+ * @param processorVersion The version of the processor the code was assembled for.
+ * @param lines Source lines the assembly map refers to.
+ * @param assemblyMap Assembly map of the assembled source lines.
+ * @return Rewrites found in the code, at most one per line.
+ */
+std::vector<Optimizer::Rewrite> Optimizer::findPeepholeRewrites(ProcessorVersion processorVersion, const QStringList &lines, const AssemblyMap &assemblyMap) {
+  std::vector<Rewrite> rewrites;
+  std::set<int> rewrittenLines;
+  const std::vector<MappedInstr> &instructions = assemblyMap.getInstructions();
+  const std::set<int> controlTargets = collectControlTargets(processorVersion, instructions);
+
+  auto isBarrier = [&](const MappedInstr &instruction) {
+    return isLabeledLine(lines, instruction.lineNumber) || controlTargets.count(instruction.address) != 0 || rewrittenLines.count(instruction.lineNumber) != 0;
+  };
+
+  for (size_t i = 0; i < instructions.size(); i++) {
+    const MappedInstr &current = instructions[i];
+    if (!FlowAnalyzer::isInstruction(current) || rewrittenLines.count(current.lineNumber) != 0) {
+      continue;
+    }
+    const QString mnemonic = Core::getInfoByOpCode(processorVersion, current.byte1).mnemonic;
+    const int nextIndex = followingInstruction(processorVersion, instructions, i);
+    const MappedInstr *next = nullptr;
+    QString nextMnemonic;
+    if (nextIndex != -1 && !isBarrier(instructions[nextIndex])) {
+      next = &instructions[nextIndex];
+      nextMnemonic = Core::getInfoByOpCode(processorVersion, next->byte1).mnemonic;
+    }
+
+    auto storeLoad = storeLoadPairs.find(mnemonic);
+    if (next != nullptr && storeLoad != storeLoadPairs.end() && nextMnemonic == storeLoad->second.first) {
+      const int address = FlowAnalyzer::operandAddress(processorVersion, current);
+      const int width = storeLoad->second.second;
+      const int nextLength = Core::getInstructionLength(processorVersion, next->byte1);
+      const bool overlapsLoad = address < next->address + nextLength && next->address < address + width;
+      if (address != -1 && address == FlowAnalyzer::operandAddress(processorVersion, *next) && address + width - 1 < Core::deviceRegistersStart && !overlapsLoad) {
+        rewrites.push_back({next->lineNumber, "", QString("removed '%1', the value was stored by line %2").arg(sourceInstruction(lines, next->lineNumber)).arg(current.lineNumber)});
+        rewrittenLines.insert(next->lineNumber);
+        continue;
+      }
+    }
+
+    if ((mnemonic == "LDAA" || mnemonic == "LDAB") && Core::getInstructionMode(processorVersion, current.byte1) == AddressingMode::IMM && current.byte2 == 0 &&
+        isFlagDead(processorVersion, instructions, i, Flag::Carry, lines, controlTargets)) {
+      const QString cleared = mnemonic == "LDAA" ? "CLRA" : "CLRB";
+      QString replacement = "\t" + cleared;
+      if (isLabeledLine(lines, current.lineNumber)) {
+        replacement.prepend(labelOf(lines, current.lineNumber));
+      }
+      rewrites.push_back({current.lineNumber, replacement, QString("replaced '%1' with '%2', the carry flag is not read").arg(sourceInstruction(lines, current.lineNumber), cleared)});
+      rewrittenLines.insert(current.lineNumber);
+      continue;
+    }
+
+    auto pair = cancellingPairs.find(mnemonic);
+    if (next != nullptr && !isBarrier(current) && pair != cancellingPairs.end() && nextMnemonic == pair->second) {
+      const bool changesZero = mnemonic == "INX" || mnemonic == "DEX";
+      if (!changesZero || isFlagDead(processorVersion, instructions, nextIndex, Flag::Zero, lines, controlTargets)) {
+        rewrites.push_back({current.lineNumber, "", QString("removed '%1', cancelled by '%2' on line %3").arg(mnemonic, nextMnemonic).arg(next->lineNumber)});
+        rewrites.push_back({next->lineNumber, "", QString("removed '%1', cancelled by '%2' on line %3").arg(nextMnemonic, mnemonic).arg(current.lineNumber)});
+        rewrittenLines.insert(current.lineNumber);
+        rewrittenLines.insert(next->lineNumber);
+      }
+    }
+  }
+  return rewrites;
+}
+
+/**
+ * @brief Compares the cycle counts of routines before and after optimization.
+ *
+ * A routine starts at the first instruction, at the first instruction after an .ORG directive and
+ * at every JSR or BSR target. Its cycle count is the sum of the base cycle counts of its
+ * instructions, each counted once. Only routines whose count changed are reported.
+ *
+ * @param processorVersion The version of the processor the code was assembled for.
+ * @param lines Original source lines, used to name the routines after their labels.
+ * @param before Assembly map of the unoptimized code.
+ * @param after Assembly map of the optimized code.
+ * @return Messages with the cycle count of every changed routine and the total.
+ */
+QList<Msg> Optimizer::compareRoutineCycles(ProcessorVersion processorVersion, const QStringList &lines, const AssemblyMap &before, const AssemblyMap &after) {
+  const std::vector<MappedInstr> &instructions = before.getInstructions();
+  std::set<int> callTargets;
+  for (const MappedInstr &instruction : instructions) {
+    if (!FlowAnalyzer::isInstruction(instruction)) {
+      continue;
+    }
+    const QString mnemonic = Core::getInfoByOpCode(processorVersion, instruction.byte1).mnemonic;
+    if ((mnemonic == "BSR" || mnemonic == "JSR") && FlowAnalyzer::transferTarget(processorVersion, instruction) != -1) {
+      callTargets.insert(FlowAnalyzer::transferTarget(processorVersion, instruction));
+    }
+  }
+
+  std::map<int, QString> routines; // first line -> name
+  bool segmentStart = true;
+  for (const MappedInstr &instruction : instructions) {
+    if (instruction.IN == ".ORG") {
+      segmentStart = true;
+    }
+    if (!FlowAnalyzer::isInstruction(instruction)) {
+      continue;
+    }
+    if (segmentStart || callTargets.count(instruction.address) != 0) {
+      QString name = QString("$%1").arg(instruction.address, 4, 16, QChar('0')).toUpper();
+      if (isLabeledLine(lines, instruction.lineNumber)) {
+        name = labelOf(lines, instruction.lineNumber).toUpper();
+      }
+      routines[instruction.lineNumber] = name;
+    }
+    segmentStart = false;
+  }
+
+  auto sumCycles = [&](const AssemblyMap &map) {
+    std::map<int, int> cycles;
+    for (const MappedInstr &instruction : map.getInstructions()) {
+      if (!FlowAnalyzer::isInstruction(instruction)) {
+        continue;
+      }
+      auto routine = routines.upper_bound(instruction.lineNumber);
+      if (routine == routines.begin()) {
+        continue;
+      }
+      cycles[std::prev(routine)->first] += Core::getInstructionCycleCount(processorVersion, instruction.byte1);
+    }
+    return cycles;
+  };
+  std::map<int, int> cyclesBefore = sumCycles(before);
+  std::map<int, int> cyclesAfter = sumCycles(after);
+
+  QList<Msg> messages;
+  int totalBefore = 0;
+  int totalAfter = 0;
+  for (const auto &[line, name] : routines) {
+    totalBefore += cyclesBefore[line];
+    totalAfter += cyclesAfter[line];
+    if (cyclesBefore[line] != cyclesAfter[line]) {
+      messages.append(Msg{MsgType::DEBUG, QString("Routine '%1' (line %2): %3 -> %4 cycles").arg(name).arg(line).arg(cyclesBefore[line]).arg(cyclesAfter[line])});
+    }
+  }
+  messages.append(Msg{MsgType::DEBUG, QString("All routines: %1 -> %2 cycles (every instruction counted once)").arg(totalBefore).arg(totalAfter)});
+  return messages;
+}
+
+/**
+ * @brief Lists JMP instructions whose target is within the range of a relative branch.
+ *
+ * BRA is one byte shorter than JMP with extended addressing but takes one cycle more, so these
+ * are only reported and left for the programmer to decide.
+ */
+QList<Msg> Optimizer::findShortJumpCandidates(ProcessorVersion processorVersion, const AssemblyMap &assemblyMap) {
+  QList<Msg> messages;
+  for (const MappedInstr &instruction : assemblyMap.getInstructions()) {
+    if (!FlowAnalyzer::isInstruction(instruction) || Core::getInstructionMode(processorVersion, instruction.byte1) != AddressingMode::EXT ||
+        Core::getInfoByOpCode(processorVersion, instruction.byte1).mnemonic != "JMP") {
+      continue;
+    }
+    const int offset = FlowAnalyzer::operandAddress(processorVersion, instruction) - (instruction.address + 2);
+    if (offset >= -128 && offset <= 127) {
+      messages.append(Msg{MsgType::DEBUG, QString("Line %1: 'JMP %2' is in branch range, BRA would save 1 byte but take 1 more cycle").arg(instruction.lineNumber).arg(instruction.OP)});
+    }
+  }
+  return messages;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "src/core/Core.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+class Optimizer {
+public:
+  struct Rewrite {
+    int lineNumber;
+    QString replacement; // empty when the line is removed
+    QString description;
+  };
+
+  static std::vector<Rewrite> findPeepholeRewrites(Core::ProcessorVersion processorVersion, const QStringList &lines, const Core::AssemblyMap &assemblyMap);
+  static QList<Core::Msg> compareRoutineCycles(Core::ProcessorVersion processorVersion, const QStringList &lines, const Core::AssemblyMap &before, const Core::AssemblyMap &after);
+  static QList<Core::Msg> findShortJumpCandidates(Core::ProcessorVersion processorVersion, const Core::AssemblyMap &assemblyMap);
+
+private:
+  using MappedInstr = Core::AssemblyMap::MappedInstr;
+
+  static bool isLabeledLine(const QStringList &lines, int lineNumber);
+  static QString labelOf(const QStringList &lines, int lineNumber);
+  static QString sourceInstruction(const QStringList &lines, int lineNumber);
+  static int followingInstruction(Core::ProcessorVersion processorVersion, const std::vector<MappedInstr> &instructions, size_t index);
+  static std::set<int> collectControlTargets(Core::ProcessorVersion processorVersion, const std::vector<MappedInstr> &instructions);
+  static bool isFlagDead(Core::ProcessorVersion processorVersion, const std::vector<MappedInstr> &instructions, size_t index, Core::Flag flag, const QStringList &lines, const std::set<int> &controlTargets);
+};
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/assembler/TimingAnalyzer.h"
+
+#include <algorithm>
+
+using Core::AddressingMode;
+using Core::AssemblyMap;
+using Core::Msg;
+using Core::MsgType;
+using Core::ProcessorVersion;
+using Loop = FlowAnalyzer::Loop;
+
+namespace {
+  // Cycles from the interrupt request to the first handler instruction, as in Processor::interruptCheckCPS
+  constexpr int resetEntryCycles = 5;
+  constexpr int interruptEntryCycles = 13;
+
+  /**
+   * @brief Reads a loop bound annotation, e.g. "; @bound 16", from the comment of a source line.
+   *
+   * @return The maximum number of times the loop header executes, or -1 if the line has no annotation.
+   */
+  int parseBoundAnnotation(const QString &line) {
+    const qsizetype comment = line.indexOf(';');
+    if (comment == -1) {
+      return -1;
+    }
+    const QString text = line.mid(comment + 1).toUpper();
+    const qsizetype tag = text.indexOf("@BOUND");
+    if (tag == -1) {
+      return -1;
+    }
+    bool ok;
+    const int bound = text.mid(tag + 6).trimmed().split(' ')[0].toInt(&ok);
+    return ok && bound > 0 ? bound : -1;
+  }
+} // namespace
+
+int TimingAnalyzer::lineOfBlock(const Context &context, int block) {
+  return context.graph.instructions[context.graph.blocks[block].firstInstruction].lineNumber;
+}
+
+/**
+ * @brief Finds the bound annotation of a loop on its first line or on the line of a back edge.
+ */
+int TimingAnalyzer::findLoopBound(const Context &context, const Loop &loop) {
+  std::vector<int> lineNumbers = {lineOfBlock(context, loop.header)};
+  for (int block : loop.blocks) {
+    const FlowAnalyzer::BasicBlock &basicBlock = context.graph.blocks[block];
+    if (std::find(basicBlock.successors.begin(), basicBlock.successors.end(), loop.header) != basicBlock.successors.end()) {
+      lineNumbers.push_back(context.graph.instructions[basicBlock.lastInstruction].lineNumber);
+    }
+  }
+  for (int lineNumber : lineNumbers) {
+    if (lineNumber >= 0 && lineNumber < context.lines.size()) {
+      const int bound = parseBoundAnnotation(context.lines[lineNumber]);
+      if (bound != -1) {
+        return bound;
+      }
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief Computes the worst-case cycles of a routine, from its entry to its last instruction.
+ *
+ * The routine is every block reachable from the entry without following calls. Results are
+ * memoized, recursive calls cannot be bounded.
+ */
+TimingAnalyzer::Bound TimingAnalyzer::routineBound(Context &context, int address) {
+  auto known = context.routineBounds.find(address);
+  if (known != context.routineBounds.end()) {
+    return known->second;
+  }
+  auto entry = context.blockByAddress.find(address);
+  if (entry == context.blockByAddress.end()) {
+    context.problems.append(QString("$%1 is not the start of assembled code").arg(QString("%1").arg(address, 4, 16, QChar('0')).toUpper()));
+    return Bound::unbounded();
+  }
+  if (!context.activeRoutines.insert(address).second) {
+    context.problems.append(QString("routine at line %1 is called recursively").arg(lineOfBlock(context, entry->second)));
+    return Bound::unbounded();
+  }
+
+  std::set<int> region;
+  std::vector<int> stack = {entry->second};
+  while (!stack.empty()) {
+    int block = stack.back();
+    stack.pop_back();
+    if (region.insert(block).second) {
+      for (int successor : context.graph.blocks[block].successors) {
+        stack.push_back(successor);
+      }
+    }
+  }
+
+  Bound bound = Bound::unbounded();
+  std::map<int, Bound> distance;
+  std::map<int, int> representative;
+  if (longestPaths(context, entry->second, region, -1, distance, representative)) {
+    bound = Bound::of(0);
+    for (const auto &[node, nodeBound] : distance) {
+      bound.bounded = bound.bounded && nodeBound.bounded;
+      bound.cycles = std::max(bound.cycles, nodeBound.cycles);
+    }
+  }
+
+  context.activeRoutines.erase(address);
+  context.routineBounds[address] = bound;
+  return bound;
+}
+
+/**
+ * @brief Computes the worst-case cycles of a block, including the routines it calls.
+ */
+TimingAnalyzer::Bound TimingAnalyzer::blockBound(Context &context, int block) {
+  const FlowAnalyzer::BasicBlock &basicBlock = context.graph.blocks[block];
+  Bound bound = Bound::of(basicBlock.cycles);
+  for (size_t i = basicBlock.firstInstruction; i <= basicBlock.lastInstruction; i++) {
+    const AssemblyMap::MappedInstr &instruction = context.graph.instructions[i];
+    const QString mnemonic = Core::getInfoByOpCode(context.processorVersion, instruction.byte1).mnemonic;
+    const bool indexed = Core::getInstructionMode(context.processorVersion, instruction.byte1) == AddressingMode::IND;
+    Bound callee = Bound::of(0);
+    if ((mnemonic == "JSR" || mnemonic == "JMP") && indexed) {
+      context.problems.append(QString("%1 on line %2 has a target computed at runtime").arg(mnemonic).arg(instruction.lineNumber));
+      callee = Bound::unbounded();
+    } else if (mnemonic == "JSR" || mnemonic == "BSR") {
+      callee = routineBound(context, FlowAnalyzer::transferTarget(context.processorVersion, instruction));
+    } else if (mnemonic == "SWI") {
+      callee = routineBound(context, (context.memory[0xFFFA] << 8) | context.memory[0xFFFB]);
+    } else if (mnemonic == "WAI") {
+      context.problems.append(QString("WAI on line %1 waits for an interrupt").arg(instruction.lineNumber));
+      callee = Bound::unbounded();
+    }
+    bound.bounded = bound.bounded && callee.bounded;
+    bound.cycles += callee.cycles;
+  }
+  return bound;
+}
+
+/**
+ * @brief Computes the worst-case cycles of a loop from its bound annotation.
+ *
+ * With a bound of n executions of the header the loop costs at most n - 1 of its longest
+ * iterations followed by its longest path to an exit.
+ */
+TimingAnalyzer::Bound TimingAnalyzer::loopBound(Context &context, const Loop &loop) {
+  auto known = context.loopBounds.find(loop.header);
+  if (known != context.loopBounds.end()) {
+    return known->second;
+  }
+  Bound bound = Bound::unbounded();
+  const int iterations = findLoopBound(context, loop);
+  std::map<int, Bound> distance;
+  std::map<int, int> representative;
+  if (iterations == -1) {
+    context.problems.append(QString("loop at line %1 has no '; @bound N' annotation").arg(lineOfBlock(context, loop.header)));
+  } else if (longestPaths(context, loop.header, loop.blocks, loop.header, distance, representative)) {
+    Bound iteration = Bound::of(0);
+    Bound exit = Bound::of(0);
+    bool hasExit = false;
+    for (int block : loop.blocks) {
+      auto path = distance.find(representative[block]);
+      if (path == distance.end()) {
+        continue;
+      }
+      const std::vector<int> &successors = context.graph.blocks[block].successors;
+      bool exits = successors.empty();
+      for (int successor : successors) {
+        if (successor == loop.header) {
+          iteration = Bound{iteration.bounded && path->second.bounded, std::max(iteration.cycles, path->second.cycles)};
+        } else if (loop.blocks.count(successor) == 0) {
+          exits = true;
+        }
+      }
+      if (exits) {
+        hasExit = true;
+        exit = Bound{exit.bounded && path->second.bounded, std::max(exit.cycles, path->second.cycles)};
+      }
+    }
+    if (hasExit) {
+      bound = Bound{iteration.bounded && exit.bounded, (iterations - 1) * iteration.cycles + exit.cycles};
+    } else {
+      context.problems.append(QString("loop at line %1 never exits").arg(lineOfBlock(context, loop.header)));
+    }
+  }
+  context.loopBounds[loop.header] = bound;
+  return bound;
+}
+
+/**
+ * @brief Computes the longest path from an entry block to every node of a region.
+ *
+ * The outermost loops inside the region are collapsed into a single node costing their loop
+ * bound, and back edges to the region header are dropped, so the remaining graph must be
+ * acyclic. A cycle left over means a loop without a single entry, which cannot be bounded.
+ *
+ * @param entry First block of the region.
+ * @param region Blocks of the routine or the loop body.
+ * @param regionHeader Header of the loop being measured, or -1 for a routine.
+ * @param distance Receives the worst-case cycles of a path from the entry to the end of each node.
+ * @param representative Receives the node of each block, the header of the collapsed loop or the block itself.
+ * @return False if the region contains a cycle which is not a natural loop.
+ */
+bool TimingAnalyzer::longestPaths(Context &context, int entry, const std::set<int> &region, int regionHeader, std::map<int, Bound> &distance, std::map<int, int> &representative) {
+  std::vector<const Loop *> innerLoops;
+  for (const Loop &loop : context.graph.loops) {
+    if (loop.header != regionHeader && region.count(loop.header) != 0 &&
+        std::all_of(loop.blocks.begin(), loop.blocks.end(), [&](int block) { return region.count(block) != 0; })) {
+      innerLoops.push_back(&loop);
+    }
+  }
+  std::sort(innerLoops.begin(), innerLoops.end(), [](const Loop *a, const Loop *b) { return a->blocks.size() > b->blocks.size(); });
+
+  for (int block : region) {
+    representative[block] = block;
+  }
+  std::map<int, const Loop *> collapsed;
+  for (const Loop *loop : innerLoops) {
+    if (representative[loop->header] != loop->header) {
+      continue; // nested in a loop collapsed before
+    }
+    collapsed[loop->header] = loop;
+    for (int block : loop->blocks) {
+      representative[block] = loop->header;
+    }
+  }
+
+  std::map<int, std::set<int>> edges;
+  for (int block : region) {
+    for (int successor : context.graph.blocks[block].successors) {
+      if (region.count(successor) == 0 || successor == regionHeader) {
+        continue;
+      }
+      if (representative[block] != representative[successor]) {
+        edges[representative[block]].insert(representative[successor]);
+      }
+    }
+  }
+
+  // Topological order by depth first search, a back edge means a cycle
+  enum class State { NEW, OPEN, DONE };
+  std::map<int, State> state;
+  std::vector<int> order;
+  std::vector<std::pair<int, std::set<int>::const_iterator>> stack;
+  const int start = representative[entry];
+  state[start] = State::OPEN;
+  stack.push_back({start, edges[start].cbegin()});
+  while (!stack.empty()) {
+    auto &[node, next] = stack.back();
+    if (next != edges[node].cend()) {
+      const int successor = *next++;
+      if (state[successor] == State::OPEN) {
+        context.problems.append(QString("cycle through line %1 is not a loop with a single entry").arg(lineOfBlock(context, successor)));
+        return false;
+      }
+      if (state[successor] == State::NEW) {
+        state[successor] = State::OPEN;
+        stack.push_back({successor, edges[successor].cbegin()});
+      }
+    } else {
+      state[node] = State::DONE;
+      order.push_back(node);
+      stack.pop_back();
+    }
+  }
+  std::reverse(order.begin(), order.end());
+
+  std::map<int, Bound> cost;
+  for (int node : order) {
+    auto loop = collapsed.find(node);
+    cost[node] = loop != collapsed.end() ? loopBound(context, *loop->second) : blockBound(context, node);
+  }
+  distance[start] = cost[start];
+  for (int node : order) {
+    for (int successor : edges[node]) {
+      const Bound candidate{distance[node].bounded && cost[successor].bounded, distance[node].cycles + cost[successor].cycles};
+      auto current = distance.find(successor);
+      if (current == distance.end()) {
+        distance[successor] = candidate;
+      } else {
+        current->second = Bound{current->second.bounded && candidate.bounded, std::max(current->second.cycles, candidate.cycles)};
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Computes a worst-case cycle bound for the RST, NMI, SWI and IRQ handlers.
+ *
+ * Each handler starts at the address stored in its vector and is bounded from the start of the
+ * interrupt entry sequence to its last instruction. Called routines are included, and every loop
+ * needs a bound annotation in a comment on its first line or on the line of its back edge:
+ * "; @bound N" limits the loop to N executions of its first line.
+ *
+ * @param processorVersion The version of the processor the code was assembled for.
+ * @param assemblyMap Assembly map of the assembled code.
+ * @param memory Assembled memory image holding the interrupt vectors.
+ * @param lines Source lines, read for loop bound annotations.
+ * @return Bound of every handler whose vector is set.
+ */
+std::vector<TimingAnalyzer::HandlerBound> TimingAnalyzer::analyzeInterruptHandlers(ProcessorVersion processorVersion, const AssemblyMap &assemblyMap, const std::array<uint8_t, 0x10000> &memory, const QStringList &lines) {
+  const FlowAnalyzer::ControlFlowGraph graph = FlowAnalyzer::buildGraph(processorVersion, assemblyMap);
+  const std::vector<std::pair<QString, uint16_t>> vectors = {{"RST", 0xFFFE}, {"NMI", 0xFFFC}, {"SWI", 0xFFFA}, {"IRQ", 0xFFF8}};
+
+  std::vector<HandlerBound> handlers;
+  for (const auto &[name, vector] : vectors) {
+    Context context{processorVersion, graph, memory, lines, {}, {}, {}, {}, {}};
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+      context.blockByAddress[graph.instructions[graph.blocks[b].firstInstruction].address] = static_cast<int>(b);
+    }
+
+    HandlerBound handler{name, vector, (memory[vector] << 8) | memory[vector + 1], interruptEntryCycles, false, 0, {}};
+    if (name == "RST") {
+      handler.entryCycles = resetEntryCycles;
+    } else if (name == "SWI") {
+      handler.entryCycles = Core::getInstructionCycleCount(processorVersion, 0x3F);
+    }
+    if (handler.entryAddress == 0 && context.blockByAddress.count(0) == 0) {
+      continue; // vector not set
+    }
+
+    const Bound bound = routineBound(context, handler.entryAddress);
+    handler.bounded = bound.bounded;
+    handler.cycles = handler.entryCycles + bound.cycles;
+    handler.problems = context.problems;
+    handler.problems.removeDuplicates();
+    handlers.push_back(handler);
+  }
+  return handlers;
+}
+
+bool TimingAnalyzer::exceedsBudget(const HandlerBound &handler, int latencyBudget) {
+  return latencyBudget > 0 && (!handler.bounded || handler.cycles > latencyBudget);
+}
+
+/**
+ * @brief Describes the handler bounds as console messages, warning about handlers over the budget.
+ *
+ * @param handlers Bounds returned by analyzeInterruptHandlers.
+ * @param latencyBudget Maximum allowed cycles of a handler, 0 to disable the check.
+ */
+QList<Msg> TimingAnalyzer::describeHandlers(const std::vector<HandlerBound> &handlers, int latencyBudget) {
+  QList<Msg> messages;
+  if (handlers.empty()) {
+    messages.append(Msg{MsgType::NONE, "No interrupt vector is set."});
+  }
+  for (const HandlerBound &handler : handlers) {
+    const QString entry = QString("%1 handler at $%2").arg(handler.name, QString("%1").arg(handler.entryAddress, 4, 16, QChar('0')).toUpper());
+    if (handler.bounded) {
+      messages.append(Msg{MsgType::NONE, QString("%1: worst case %2 cycles, including %3 entry cycles").arg(entry).arg(handler.cycles).arg(handler.entryCycles)});
+    } else {
+      messages.append(Msg{MsgType::WARN, QString("%1: no worst case bound").arg(entry)});
+      for (const QString &problem : handler.problems) {
+        messages.append(Msg{MsgType::WARN, QString("    %1").arg(problem)});
+      }
+    }
+    if (exceedsBudget(handler, latencyBudget)) {
+      messages.append(Msg{MsgType::WARN, QString("%1 exceeds the latency budget of %2 cycles").arg(entry).arg(latencyBudget)});
+    }
+  }
+  return messages;
+}
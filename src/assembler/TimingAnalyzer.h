@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TIMINGANALYZER_H
+#define TIMINGANALYZER_H
+
+#include "src/assembler/FlowAnalyzer.h"
+#include "src/core/Core.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <array>
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+class TimingAnalyzer {
+public:
+  struct HandlerBound {
+    QString name;
+    uint16_t vector;
+    int entryAddress;
+    int entryCycles; // interrupt entry sequence, or the SWI instruction
+    bool bounded;
+    int cycles; // entry cycles included
+    QStringList problems;
+  };
+
+  static std::vector<HandlerBound> analyzeInterruptHandlers(Core::ProcessorVersion processorVersion, const Core::AssemblyMap &assemblyMap, const std::array<uint8_t, 0x10000> &memory, const QStringList &lines);
+  static QList<Core::Msg> describeHandlers(const std::vector<HandlerBound> &handlers, int latencyBudget);
+  static bool exceedsBudget(const HandlerBound &handler, int latencyBudget);
+
+private:
+  struct Bound {
+    bool bounded;
+    int cycles;
+
+    static Bound unbounded() { return {false, 0}; }
+    static Bound of(int cycles) { return {true, cycles}; }
+  };
+  struct Context {
+    Core::ProcessorVersion processorVersion;
+    const FlowAnalyzer::ControlFlowGraph &graph;
+    const std::array<uint8_t, 0x10000> &memory;
+    const QStringList &lines;
+    std::map<int, int> blockByAddress;
+    std::map<int, Bound> routineBounds;
+    std::map<int, Bound> loopBounds;
+    std::set<int> activeRoutines;
+    QStringList problems;
+  };
+
+  static int lineOfBlock(const Context &context, int block);
+  static int findLoopBound(const Context &context, const FlowAnalyzer::Loop &loop);
+  static Bound routineBound(Context &context, int address);
+  static Bound blockBound(Context &context, int block);
+  static Bound loopBound(Context &context, const FlowAnalyzer::Loop &loop);
+  static bool longestPaths(Context &context, int entry, const std::set<int> &region, int regionHeader, std::map<int, Bound> &distance, std::map<int, int> &representative);
+};
+
+#endif // TIMINGANALYZER_H
@@ -79,12 +79,12 @@ namespace Core {
       {ActionType::SETRST, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
       {ActionType::SETNMI, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
       {ActionType::SETIRQ, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
-      {ActionType::SETKEY, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
-      {ActionType::SETMOUSECLICK, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
-      {ActionType::SETMOUSEX, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
-      {ActionType::SETMOUSEY, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
+      {ActionType::SETKEY, {ActionExecutionTiming::BEFORE_INSTRUCTION, false}},
       {ActionType::SETMEMORY, {ActionExecutionTiming::WHEN_READY, false}},
       {ActionType::SETMEMORYBULK, {ActionExecutionTiming::WHEN_READY, true}},
+      {ActionType::SETSERIALADDRESS, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
+      {ActionType::SETSERIALBAUD, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
+      {ActionType::SETBLOCKIMAGE, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
       {ActionType::SETIRQONKEYPRESS, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
       {ActionType::SETINCONINVALIDINSTR, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
       {ActionType::UPDATEPROCESSORSPEED, {ActionExecutionTiming::BEFORE_INSTRUCTION, true}},
@@ -20,7 +20,13 @@
 #include <QMap>
 #include <QString>
 
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <iterator>
+#include <map>
 #include <stdint.h>
+#include <unordered_map>
 #include <vector>
 
 class QColor;
@@ -36,6 +42,14 @@ namespace Core {
   extern const QColor SMMemoryCellColor2;
 
   inline constexpr uint16_t interruptLocations = 0xFFFF;
+  inline constexpr uint16_t ioRegistersStart = 0xFFF0; // memory mapped input registers, reads may change between accesses
+  inline constexpr uint16_t deviceRegistersStart = 0xFFE0; // registers of emulated peripherals, accesses can have side effects, not usable as RAM
+  inline constexpr uint16_t deviceRegistersEnd = 0xFFF8;   // first address past the device registers, the interrupt vectors follow
+  inline constexpr uint16_t displayBufferStart = 0xFB00; // character display, one byte per cell, row by row
+  inline constexpr int displayColumns = 54;
+  inline constexpr int displayRows = 20;
+
+  using AddressSet = std::bitset<0x10000>; // one bit per memory address
 
   class AssemblyMap {
   public:
@@ -53,40 +67,149 @@ namespace Core {
           : address(addr), lineNumber(line), byte1(b1), byte2(b2), byte3(b3), IN(in), OP(op) {
       }
     };
+    struct AddressRange {
+      int begin; // first address, -1 if there is no range
+      int end;   // one past the last address
+      int lineNumber;
+    };
 
     void clear() {
       instructions.clear();
+      addressIndex.clear();
+      bankedIndex.clear();
+      bankWindowStart = 0;
+      bankWindowEnd = 0;
+      lineIndex.clear();
+      ranges.clear();
+      lineRanges.clear();
     }
     bool isEmpty() const {
       return instructions.empty();
     }
+    const std::vector<MappedInstr> &getInstructions() const {
+      return instructions;
+    }
 
-    void addInstruction(int address, int lineNumber, uint8_t byte1, uint8_t byte2, uint8_t byte3, const QString &IN, const QString &OP) {
-      instructions.emplace_back(address, lineNumber, byte1, byte2, byte3, IN, OP);
+    // addresses in the window are looked up in the mapped bank, code of other banks shares them with bank 0
+    void setBankWindow(int start, int size) {
+      bankWindowStart = start;
+      bankWindowEnd = start + size;
+    }
+    bool inBankWindow(int address) const {
+      return address >= bankWindowStart && address < bankWindowEnd;
     }
 
-    MappedInstr &getObjectByAddress(int address) {
-      for (MappedInstr &instruction : instructions) {
-        if (instruction.address == address) {
-          return instruction;
+    // the indexes keep the first entry of an address or line, entries are never removed
+    void addInstruction(int address, int lineNumber, uint8_t byte1, uint8_t byte2, uint8_t byte3, const QString &IN, const QString &OP, int bank = 0) {
+      int index = static_cast<int>(instructions.size());
+      instructions.emplace_back(address, lineNumber, byte1, byte2, byte3, IN, OP);
+      if (address >= 0 && address <= 0xFFFF && bank != 0) {
+        bankedIndex.emplace((bank << 16) | address, index);
+      } else if (address >= 0 && address <= 0xFFFF) {
+        if (addressIndex.empty()) {
+          addressIndex.assign(0x10000, -1);
+        }
+        if (addressIndex[address] == -1) {
+          addressIndex[address] = index;
+        }
+      }
+      if (lineNumber >= 0) {
+        if (lineNumber >= static_cast<int>(lineIndex.size())) {
+          lineIndex.resize(lineNumber + 1, -1);
+        }
+        if (lineIndex[lineNumber] == -1) {
+          lineIndex[lineNumber] = index;
         }
       }
-      static MappedInstr defaultInstruction = MappedInstr{address, -1, 0, 0, 0, "", ""}; // FIXME NOT THREAD SAFE
-      return defaultInstruction;
     }
 
-    MappedInstr &getObjectByLine(int lineNumber) {
-      for (MappedInstr &instruction : instructions) {
-        if (instruction.lineNumber == lineNumber) {
-          return instruction;
+    const MappedInstr &getObjectByAddress(int address, int bank = 0) const {
+      if (bank != 0 && inBankWindow(address)) {
+        auto it = bankedIndex.find((bank << 16) | address);
+        return it != bankedIndex.end() ? instructions[it->second] : missingInstruction;
+      }
+      if (address < 0 || address >= static_cast<int>(addressIndex.size()) || addressIndex[address] == -1) {
+        return missingInstruction;
+      }
+      return instructions[addressIndex[address]];
+    }
+    // by line rather than address, instructions of different banks can share an address
+    void setOperandBytes(int lineNumber, uint8_t byte2, uint8_t byte3) {
+      if (lineNumber >= 0 && lineNumber < static_cast<int>(lineIndex.size()) && lineIndex[lineNumber] != -1) {
+        instructions[lineIndex[lineNumber]].byte2 = byte2;
+        instructions[lineIndex[lineNumber]].byte3 = byte3;
+      }
+    }
+
+    const MappedInstr &getObjectByLine(int lineNumber) const {
+      if (lineNumber < 0 || lineNumber >= static_cast<int>(lineIndex.size()) || lineIndex[lineNumber] == -1) {
+        return missingInstruction;
+      }
+      return instructions[lineIndex[lineNumber]];
+    }
+
+    // bytes written by a line, a later range takes over the bytes it shares with earlier ones
+    // only bank 0 is kept for address queries, the ranges of other banks are found by line
+    void addRange(int begin, int size, int lineNumber, int bank = 0) {
+      if (size <= 0 || begin < 0 || lineNumber < 0) {
+        return;
+      }
+      int end = std::min(begin + size, 0x10000);
+      if (lineNumber >= static_cast<int>(lineRanges.size())) {
+        lineRanges.resize(lineNumber + 1, AddressRange{-1, -1, -1});
+      }
+      if (lineRanges[lineNumber].begin == -1) {
+        lineRanges[lineNumber] = AddressRange{begin, end, lineNumber};
+      }
+      if (bank != 0) {
+        return;
+      }
+
+      auto it = ranges.upper_bound(begin);
+      if (it != ranges.begin() && std::prev(it)->second.end > begin) {
+        it = std::prev(it);
+      }
+      while (it != ranges.end() && it->first < end) {
+        AddressRange overlapped = it->second;
+        it = ranges.erase(it);
+        if (overlapped.begin < begin) {
+          ranges[overlapped.begin] = AddressRange{overlapped.begin, begin, overlapped.lineNumber};
         }
+        if (overlapped.end > end) {
+          ranges[end] = AddressRange{end, overlapped.end, overlapped.lineNumber};
+        }
+      }
+      ranges[begin] = AddressRange{begin, end, lineNumber};
+    }
+
+    AddressRange getRangeContaining(int address, int bank = 0) const {
+      if (bank != 0 && inBankWindow(address)) {
+        return AddressRange{-1, -1, -1};
+      }
+      auto it = ranges.upper_bound(address);
+      if (it == ranges.begin() || std::prev(it)->second.end <= address) {
+        return AddressRange{-1, -1, -1};
       }
-      static MappedInstr defaultInstruction = {-1, lineNumber, 0, 0, 0, "", ""}; // FIXME NOT THREAD SAFE
-      return defaultInstruction;
+      return std::prev(it)->second;
+    }
+    AddressRange getRangeOfLine(int lineNumber) const {
+      if (lineNumber < 0 || lineNumber >= static_cast<int>(lineRanges.size())) {
+        return AddressRange{-1, -1, -1};
+      }
+      return lineRanges[lineNumber];
     }
 
   private:
+    inline static const MappedInstr missingInstruction{-1, -1, 0, 0, 0, "", ""};
+
     std::vector<MappedInstr> instructions;
+    std::vector<int> addressIndex; // address -> index into instructions, 64K entries once anything is added
+    std::vector<int> lineIndex;    // line -> index into instructions
+    std::unordered_map<int, int> bankedIndex; // address plus bank times $10000 -> index, for banks other than bank 0
+    int bankWindowStart = 0;
+    int bankWindowEnd = 0;
+    std::map<int, AddressRange> ranges; // begin -> disjoint range, for O(log n) address queries
+    std::vector<AddressRange> lineRanges; // line -> first range the line wrote
   };
   enum class MemoryDisplayMode {
     NONE,
@@ -159,11 +282,11 @@ namespace Core {
     SETNMI,
     SETIRQ,
     SETKEY,
-    SETMOUSECLICK,
-    SETMOUSEX,
-    SETMOUSEY,
     SETMEMORY,
     SETMEMORYBULK,
+    SETSERIALADDRESS,
+    SETSERIALBAUD,
+    SETBLOCKIMAGE,
     SETIRQONKEYPRESS,
     SETINCONINVALIDINSTR,
     UPDATEPROCESSORSPEED,
@@ -186,6 +309,45 @@ namespace Core {
     ActionType type;
     uint32_t parameter;
   };
+  struct PerformanceSample {
+    uint64_t instructions;   // executed since the start of execution
+    uint64_t cycles;         // executed since the start of execution
+    int64_t busyNanoseconds; // time the execution thread spent executing rather than waiting for pacing
+    int64_t capturedAt;      // steady clock time of the capture in nanoseconds
+    int64_t copyNanoseconds; // time taken to capture the snapshot
+    int actionQueueDepth;
+  };
+  // a window of the address space showing one bank of a larger backing store at a time
+  struct BankLayout {
+    uint16_t windowStart = 0x8000;
+    int windowSize = 0x4000; // 4K, 8K or 16K
+    int bankCount = 0;       // 0 when banking is off and the window is plain memory
+
+    bool enabled() const { return bankCount > 0; }
+    bool contains(int address) const { return enabled() && address >= windowStart && address < windowStart + windowSize; }
+    bool isValid() const {
+      if (!enabled()) {
+        return bankCount == 0;
+      }
+      bool sizeValid = windowSize == 0x1000 || windowSize == 0x2000 || windowSize == 0x4000;
+      return sizeValid && bankCount >= 2 && bankCount <= 256 && windowStart % windowSize == 0 && windowStart + windowSize <= deviceRegistersStart;
+    }
+  };
+  struct ProcessorSnapshot {
+    std::array<uint8_t, 0x10000> memory;
+    int bank; // bank mapped into the window, 0 when banking is off
+    int curCycle;
+    uint8_t flags;
+    uint16_t PC;
+    uint16_t SP;
+    uint8_t aReg;
+    uint8_t bReg;
+    uint16_t xReg;
+    bool useCycles;
+    uint64_t operationsSinceStart;
+    PerformanceSample performance;
+    int replacedSnapshots; // snapshots published and replaced before the UI took one, since the last one it took
+  };
 
   struct AssemblyError {
     bool ok;
@@ -196,10 +358,17 @@ namespace Core {
     static AssemblyError failure(const QString &message, int errorLineNum, int errorCharNum) { return {false, message, errorLineNum, errorCharNum}; }
     static AssemblyError none() { return AssemblyError{true, "", -1, -1}; }
   };
+  struct AssemblyOptions {
+    bool optimizeDirectAddressing = false;
+    bool peepholeOptimization = false;
+    BankLayout banks; // the window .BANK sections are assembled into
+  };
   struct AssemblyResult {
     QList<Msg> messages;
     AssemblyError error;
     AssemblyMap assemblyMap;
+    std::map<QString, int> symbols; // label values, names are upper case
+    std::map<int, std::vector<uint8_t>> banks; // window contents of the banks other than bank 0, which is assembled into memory
   };
   struct DisassemblyResult {
     QList<Msg> messages;
@@ -815,7 +984,8 @@ namespace Core {
   }
   inline const QList<QString> directivesWithLocation = {".BYTE", ".WORD", ".STR"};
 
-  inline const QMap<QString, Allias> alliasMap = {{"BYTE", {".BYTE", "Allias for .BYTE", M6800 | M6803}},
+  inline const QMap<QString, Allias> alliasMap = {{"BANK", {".BANK", "Allias for .BANK", M6800 | M6803}},
+                                                  {"BYTE", {".BYTE", "Allias for .BYTE", M6800 | M6803}},
                                                   {"EQU", {".EQU", "Allias for .EQU", M6800 | M6803}},
                                                   {"ORG", {".ORG", "Allias for .ORG", M6800 | M6803}},
                                                   {"RMB", {".RMB", "Allias for .RMB", M6800 | M6803}},
@@ -831,6 +1001,7 @@ namespace Core {
                                                   {"BLO", {"BCS", "Allias for BCS. Branch if *unsigned* value is lower", M6803}}};
   inline const MnemonicInfo invalidMnemonic{"INVALID", {0, 0, 0, 0, 0, 0}, "", "", "", 0};
   inline const MnemonicInfo mnemonics[] = {
+      {".BANK", {}, "", "Select Bank", "Assembles the following code and data that lies in the bank window into the specified bank. Bank 0 is mapped at reset and assembled into memory like code outside the window.", M6800 | M6803},
       {".BYTE", {}, "", "Set Byte", "Sets a 1-byte value or an array of such values to the current address. Values can also be written in an array separated by commas.", M6800 | M6803},
       {".EQU", {}, "", "Set Constant", "Associates a specified value with a symbol/label.", M6800 | M6803},
       {".ORG", {}, "", "Set Compilation Address", "Sets the current compilation address. Writes the operand to the reset pointer((n-1):n).", M6800 | M6803},
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/core/TerminalDisplay.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <conio.h>
+#include <windows.h>
+#else
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+  DWORD originalOutputMode = 0;
+#else
+  termios originalAttributes;
+  bool attributesChanged = false;
+#endif
+
+  /**
+   * @brief Converts a byte typed into the terminal to the value the display widgets write for the key.
+   *
+   * Letters are reported in upper case like the Qt key codes, keys without a value return 0.
+   */
+  uint8_t keyValue(uint8_t byte) {
+    if (byte >= 'a' && byte <= 'z') {
+      return byte - 'a' + 'A';
+    }
+    if (byte >= 0x20 && byte <= 0x7E) {
+      return byte;
+    }
+    switch (byte) {
+    case '\r':
+    case '\n':
+      return 13;
+    case 8:
+    case 127:
+      return 8;
+    case 9:
+      return 9;
+    case 27:
+      return 27;
+    default:
+      return 0;
+    }
+  }
+} // namespace
+
+TerminalDisplay::TerminalDisplay(const std::string &statusLine) : footer(statusLine.empty() ? "Ctrl+C to stop" : "Ctrl+C to stop    " + statusLine) {
+#ifdef _WIN32
+  HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+  if (GetConsoleMode(output, &originalOutputMode)) {
+    SetConsoleMode(output, originalOutputMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+  }
+#else
+  // signals stay enabled so Ctrl+C still stops the program
+  if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &originalAttributes) == 0) {
+    termios attributes = originalAttributes;
+    attributes.c_lflag &= ~(ICANON | ECHO);
+    attributes.c_cc[VMIN] = 0;
+    attributes.c_cc[VTIME] = 0;
+    attributesChanged = tcsetattr(STDIN_FILENO, TCSANOW, &attributes) == 0;
+  }
+#endif
+  write("\x1b[?25l\x1b[2J");
+}
+
+TerminalDisplay::~TerminalDisplay() {
+  write("\x1b[" + std::to_string(Core::displayRows + 4) + ";1H\x1b[?25h");
+#ifdef _WIN32
+  SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), originalOutputMode);
+#else
+  if (attributesChanged) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &originalAttributes);
+  }
+#endif
+}
+
+/**
+ * @brief Writes the cells which changed since the previous frame.
+ *
+ * Changed cells of a row are written as runs after one cursor movement each. Short gaps of
+ * unchanged cells are written over instead, which is cheaper than moving the cursor past them.
+ * The first frame also draws the frame around the display.
+ */
+void TerminalDisplay::draw(const std::array<uint8_t, 0x10000> &memory) {
+  const uint8_t *buffer = memory.data() + Core::displayBufferStart;
+  auto changed = [this, buffer](int index) { return !drawn || cells[index] != buffer[index]; };
+  std::string output;
+
+  if (!drawn) {
+    std::string edge = "+" + std::string(Core::displayColumns, '-') + "+";
+    output += "\x1b[1;1H" + edge;
+    for (int row = 0; row < Core::displayRows; ++row) {
+      output += "\x1b[" + std::to_string(row + 2) + ";1H|\x1b[" + std::to_string(Core::displayColumns + 2) + "G|";
+    }
+    output += "\x1b[" + std::to_string(Core::displayRows + 2) + ";1H" + edge + "\r\n" + footer;
+  }
+
+  for (int row = 0; row < Core::displayRows; ++row) {
+    int rowStart = row * Core::displayColumns;
+    int column = 0;
+    while (column < Core::displayColumns) {
+      while (column < Core::displayColumns && !changed(rowStart + column)) {
+        column++;
+      }
+      if (column == Core::displayColumns) {
+        break;
+      }
+      int last = column;
+      for (int next = column + 1; next < Core::displayColumns && next - last <= maxSkippedCells; ++next) {
+        if (changed(rowStart + next)) {
+          last = next;
+        }
+      }
+      output += "\x1b[" + std::to_string(row + 2) + ";" + std::to_string(column + 2) + "H";
+      for (; column <= last; ++column) {
+        uint8_t value = buffer[rowStart + column];
+        cells[rowStart + column] = value;
+        QChar character = Core::numToChar(value);
+        output += character.isNull() ? ' ' : static_cast<char>(character.unicode());
+      }
+    }
+  }
+  drawn = true;
+
+  if (!output.empty()) {
+    write(output);
+  }
+}
+
+/**
+ * @brief Returns the values of the keys typed since the previous call, without waiting.
+ *
+ * Escape sequences of cursor and function keys are dropped, the display has no values for them.
+ */
+std::vector<uint8_t> TerminalDisplay::readKeys() {
+  std::vector<uint8_t> bytes;
+#ifdef _WIN32
+  while (_kbhit()) {
+    int character = _getch();
+    if (character == 0 || character == 0xE0) {
+      _getch(); // second half of a cursor or function key
+      continue;
+    }
+    bytes.push_back(static_cast<uint8_t>(character));
+  }
+#else
+  while (inputOpen) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(STDIN_FILENO, &readable);
+    timeval timeout{0, 0};
+    if (select(STDIN_FILENO + 1, &readable, nullptr, nullptr, &timeout) <= 0) {
+      break;
+    }
+    uint8_t input[64];
+    ssize_t count = ::read(STDIN_FILENO, input, sizeof(input));
+    if (count <= 0) {
+      inputOpen = false; // end of piped input
+      break;
+    }
+    bytes.insert(bytes.end(), input, input + count);
+  }
+#endif
+
+  std::vector<uint8_t> keys;
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    if (bytes[i] == 27 && i + 1 < bytes.size() && (bytes[i + 1] == '[' || bytes[i + 1] == 'O')) {
+      i += 2;
+      while (i < bytes.size() && (bytes[i] < 0x40 || bytes[i] > 0x7E)) {
+        i++;
+      }
+      continue;
+    }
+    if (uint8_t value = keyValue(bytes[i]); value != 0) {
+      keys.push_back(value);
+    }
+  }
+  return keys;
+}
+
+void TerminalDisplay::write(const std::string &output) {
+  std::fwrite(output.data(), 1, output.size(), stdout);
+  std::fflush(stdout);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TERMINALDISPLAY_H
+#define TERMINALDISPLAY_H
+
+#include "src/core/Core.h"
+
+#include <array>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Mirrors the character display in a text terminal and reads key presses from it.
+ *
+ * The screen is cleared, the cursor hidden and line buffering disabled for the lifetime of the
+ * object. When it is destroyed the last frame is left on screen and the terminal is restored.
+ */
+class TerminalDisplay {
+public:
+  explicit TerminalDisplay(const std::string &statusLine = std::string());
+  ~TerminalDisplay();
+  TerminalDisplay(const TerminalDisplay &) = delete;
+  TerminalDisplay &operator=(const TerminalDisplay &) = delete;
+
+  void draw(const std::array<uint8_t, 0x10000> &memory);
+  std::vector<uint8_t> readKeys();
+
+private:
+  static constexpr int maxSkippedCells = 6; // unchanged cells rewritten rather than moving the cursor past them
+
+  std::array<uint8_t, Core::displayColumns * Core::displayRows> cells{};
+  std::string footer;
+  bool drawn = false;
+  bool inputOpen = true;
+
+  static void write(const std::string &output);
+};
+
+#endif // TERMINALDISPLAY_H
@@ -16,13 +16,18 @@
  */
 #include <QApplication>
 #include "src/assembler/Assembler.h"
+#include "src/assembler/TimingAnalyzer.h"
 #include "src/core/Core.h"
+#include "src/core/TerminalDisplay.h"
 #include "src/mainwindow/MainWindow.h"
+#include "src/processor/Processor.h"
+#include "src/utils/SerialHost.h"
 #include <array>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <csignal>
 
 using Core::AssemblyResult;
@@ -38,6 +43,26 @@ void printHelp() {
             << "    --input, --in <file>          Input assembly file (required)\n"
             << "    --output, --out <file>        Output binary file (default: assembled_M6800.bin)\n"
             << "    --processor, --proc <ver>     Processor version (M6800 or M6803, default: M6800)\n"
+            << "    --optimize-direct, --opt-dir  Select direct addressing for forward referenced labels in the direct page\n"
+            << "    --optimize-peephole, --opt-peep  Apply peephole rewrites and report the cycle count of changed routines\n"
+            << "    --wcet                        Report the worst case cycles of the interrupt handlers\n"
+            << "    --wcet-budget <cycles>        Like --wcet, and fail if a handler exceeds the budget\n"
+            << "    --banks <count>               Number of memory banks for .BANK, appended to the output after bank 0\n"
+            << "    --bank-window <address>       Hexadecimal address of the bank window (default: 8000)\n"
+            << "    --bank-size <size>            Size of the bank window in kilobytes, 4, 8 or 16 (default: 16)\n"
+            << "  --run                           Assemble a file and run it, showing the display in the terminal\n"
+            << "    --input, --in <file>          Input assembly file (required)\n"
+            << "    --processor, --proc <ver>     Processor version (M6800 or M6803, default: M6800)\n"
+            << "    --speed <ops>                 Operations per second (default: 1000000)\n"
+            << "    --cycles                      Count operations in cycles instead of instructions\n"
+            << "    --irq-on-key                  Request an IRQ when a key is pressed\n"
+            << "    --fps <frames>                Display refreshes per second (default: 30)\n"
+            << "    --serial <line>               Connect the ACIA to stdio (instead of the display) or to a new pty\n"
+            << "    --serial-address <address>    Hexadecimal address of the ACIA registers (default: FFE0)\n"
+            << "    --baud <rate>                 ACIA baud rate at the divide by 16 setting (default: 9600)\n"
+            << "    --disk <file>                 Disk image for the block storage device, in 256 byte sectors\n"
+            << "    --disk-readonly               Reject writes to the disk image\n"
+            << "    --banks, --bank-window, --bank-size  Banked memory, as for --asm, selected through $FFE4\n"
             << "Running without arguments launches the GUI mode.\n";
 }
 
@@ -56,21 +81,74 @@ bool readInputFile(const std::string& inputFile, std::string& content) {
   return true;
 }
 
-bool writeOutputFile(const std::string& outputFile, const std::array<uint8_t, 0x10000>& memory) {
+bool writeOutputFile(const std::string& outputFile, const std::array<uint8_t, 0x10000>& memory, const Core::BankLayout& banks, const std::map<int, std::vector<uint8_t>>& bankContents) {
   std::ofstream outFile(outputFile, std::ios::binary);
   if (!outFile) {
     std::cerr << "Error: Unable to open output file '" << outputFile << "' for writing\n";
     return false;
   }
   outFile.write(reinterpret_cast<const char*>(memory.data()), memory.size());
+  // banks 1 and up follow the address space, which holds bank 0 in its window
+  const std::vector<uint8_t> emptyBank(banks.windowSize, 0);
+  for (int bank = 1; bank < banks.bankCount; ++bank) {
+    auto contents = bankContents.find(bank);
+    const std::vector<uint8_t>& bytes = contents != bankContents.end() ? contents->second : emptyBank;
+    outFile.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
   outFile.close();
   return true;
 }
 
+// parses the banked memory options of the assembly and run modes, returns 0 for other flags and -1 on errors
+int parseBankOption(const std::string& flag, int& i, int argc, char* argv[], Core::BankLayout& banks) {
+  bool ok = false;
+  if (flag == "--banks") {
+    if (++i < argc) {
+      banks.bankCount = QString(argv[i]).toInt(&ok);
+    }
+    if (!ok || banks.bankCount < 2 || banks.bankCount > 256) {
+      std::cerr << "Error: --banks requires a number of banks between 2 and 256\n";
+      return -1;
+    }
+  } else if (flag == "--bank-window") {
+    if (++i < argc) {
+      banks.windowStart = QString(argv[i]).remove('$').toUShort(&ok, 16);
+    }
+    if (!ok) {
+      std::cerr << "Error: --bank-window requires a hexadecimal address\n";
+      return -1;
+    }
+  } else if (flag == "--bank-size") {
+    int kilobytes = 0;
+    if (++i < argc) {
+      kilobytes = QString(argv[i]).toInt(&ok);
+    }
+    if (!ok || (kilobytes != 4 && kilobytes != 8 && kilobytes != 16)) {
+      std::cerr << "Error: --bank-size requires 4, 8 or 16\n";
+      return -1;
+    }
+    banks.windowSize = kilobytes * 1024;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+bool validateBankLayout(const Core::BankLayout& banks) {
+  if (!banks.isValid()) {
+    std::cerr << "Error: The bank window must be aligned to its size and end below $" << QString::number(Core::deviceRegistersStart, 16).toUpper().toStdString() << "\n";
+    return false;
+  }
+  return true;
+}
+
 int handleAssembly(int argc, char* argv[]) {
   Core::ProcessorVersion processorVersion = Core::ProcessorVersion::M6800;
   std::string inputFile;
   std::string outputFile;
+  Core::AssemblyOptions options;
+  bool analyzeTiming = false;
+  int latencyBudget = 0;
 
   // Parse command-line arguments for assembly mode
   for (int i = 2; i < argc; ++i) {
@@ -102,6 +180,26 @@ int handleAssembly(int argc, char* argv[]) {
         std::cerr << "Error: --processor requires a version argument\n";
         return 1;
       }
+    } else if (flag == "--optimize-direct" || flag == "--opt-dir") {
+      options.optimizeDirectAddressing = true;
+    } else if (flag == "--optimize-peephole" || flag == "--opt-peep") {
+      options.peepholeOptimization = true;
+    } else if (flag == "--wcet") {
+      analyzeTiming = true;
+    } else if (flag == "--wcet-budget") {
+      analyzeTiming = true;
+      bool ok = false;
+      if (++i < argc) {
+        latencyBudget = QString(argv[i]).toInt(&ok);
+      }
+      if (!ok || latencyBudget <= 0) {
+        std::cerr << "Error: --wcet-budget requires a positive cycle count\n";
+        return 1;
+      }
+    } else if (int parsed = parseBankOption(flag, i, argc, argv, options.banks); parsed != 0) {
+      if (parsed < 0) {
+        return 1;
+      }
     } else {
       std::cerr << "Error: Unknown option '" << flag << "'\n";
       return 1;
@@ -112,6 +210,9 @@ int handleAssembly(int argc, char* argv[]) {
     std::cerr << "Error: --input <file> is required for assembly mode\n";
     return 1;
   }
+  if (!validateBankLayout(options.banks)) {
+    return 1;
+  }
 
   std::string fileContent;
   if (!readInputFile(inputFile, fileContent)) {
@@ -120,7 +221,7 @@ int handleAssembly(int argc, char* argv[]) {
   QString qFileContent = QString::fromStdString(fileContent);
 
   std::array<uint8_t, 0x10000> memory = {0};
-  AssemblyResult status = Assembler::assemble(processorVersion, qFileContent, memory);
+  AssemblyResult status = Assembler::assemble(processorVersion, qFileContent, memory, options);
 
   for (const Msg& message : status.messages) {
     std::cout << message.message.toStdString() << std::endl;
@@ -137,11 +238,235 @@ int handleAssembly(int argc, char* argv[]) {
   if (outputFile.empty()) {
     outputFile = "assembled_" + (processorVersion == Core::ProcessorVersion::M6803 ? std::string("M6803") : std::string("M6800")) + ".bin";
   }
-  if (!writeOutputFile(outputFile, memory)) {
+  if (!writeOutputFile(outputFile, memory, options.banks, status.banks)) {
     return 1;
   }
 
   std::cout << "Assembly completed successfully. Output written to " << outputFile << std::endl;
+
+  if (analyzeTiming) {
+    const std::vector<TimingAnalyzer::HandlerBound> handlers = TimingAnalyzer::analyzeInterruptHandlers(processorVersion, status.assemblyMap, memory, qFileContent.split('\n'));
+    for (const Msg& message : TimingAnalyzer::describeHandlers(handlers, latencyBudget)) {
+      std::cout << message.message.toStdString() << std::endl;
+    }
+    for (const TimingAnalyzer::HandlerBound& handler : handlers) {
+      if (TimingAnalyzer::exceedsBudget(handler, latencyBudget)) {
+        std::cerr << "Error: Interrupt latency budget exceeded.\n";
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+volatile std::sig_atomic_t runInterrupted = 0;
+
+void interruptHandler(int) {
+  runInterrupted = 1;
+}
+
+int handleRun(int argc, char* argv[]) {
+  Core::ProcessorVersion processorVersion = Core::ProcessorVersion::M6800;
+  std::string inputFile;
+  double speed = 1000000;
+  bool useCycles = false;
+  bool irqOnKey = false;
+  int framesPerSecond = 30;
+  std::string serialLine;
+  uint16_t serialAddress = Acia6850::defaultAddress;
+  int baudRate = Acia6850::defaultBaudRate;
+  std::string diskFile;
+  bool diskReadOnly = false;
+  Core::BankLayout banks;
+
+  // Parse command-line arguments for run mode
+  for (int i = 2; i < argc; ++i) {
+    std::string flag = argv[i];
+    if (flag == "--input" || flag == "--in") {
+      if (++i < argc)
+        inputFile = argv[i];
+      else {
+        std::cerr << "Error: --input requires a file argument\n";
+        return 1;
+      }
+    } else if (flag == "--processor" || flag == "--proc") {
+      if (++i < argc) {
+        std::string procVersionStr = argv[i];
+        if (procVersionStr == "M6803") {
+          processorVersion = Core::ProcessorVersion::M6803;
+        } else if (procVersionStr != "M6800") {
+          std::cerr << "Error: Invalid processor version. Use M6800 or M6803.\n";
+          return 1;
+        }
+      } else {
+        std::cerr << "Error: --processor requires a version argument\n";
+        return 1;
+      }
+    } else if (flag == "--speed") {
+      bool ok = false;
+      if (++i < argc) {
+        speed = QString(argv[i]).toDouble(&ok);
+      }
+      if (!ok || speed <= 0 || speed > 1000000000) {
+        std::cerr << "Error: --speed requires a positive number of operations per second\n";
+        return 1;
+      }
+    } else if (flag == "--cycles") {
+      useCycles = true;
+    } else if (flag == "--irq-on-key") {
+      irqOnKey = true;
+    } else if (flag == "--fps") {
+      bool ok = false;
+      if (++i < argc) {
+        framesPerSecond = QString(argv[i]).toInt(&ok);
+      }
+      if (!ok || framesPerSecond <= 0 || framesPerSecond > 1000) {
+        std::cerr << "Error: --fps requires a number of frames between 1 and 1000\n";
+        return 1;
+      }
+    } else if (flag == "--serial") {
+      if (++i < argc) {
+        serialLine = argv[i];
+      }
+      if (serialLine != "stdio" && serialLine != "pty") {
+        std::cerr << "Error: --serial requires stdio or pty\n";
+        return 1;
+      }
+    } else if (flag == "--serial-address") {
+      bool ok = false;
+      if (++i < argc) {
+        serialAddress = QString(argv[i]).remove('$').toUShort(&ok, 16);
+      }
+      if (!ok) {
+        std::cerr << "Error: --serial-address requires a hexadecimal address\n";
+        return 1;
+      }
+    } else if (flag == "--baud") {
+      bool ok = false;
+      if (++i < argc) {
+        baudRate = QString(argv[i]).toInt(&ok);
+      }
+      if (!ok || baudRate < 50 || baudRate > Acia6850::clockHz / 16) {
+        std::cerr << "Error: --baud requires a rate between 50 and " << Acia6850::clockHz / 16 << "\n";
+        return 1;
+      }
+    } else if (flag == "--disk") {
+      if (++i < argc)
+        diskFile = argv[i];
+      else {
+        std::cerr << "Error: --disk requires a file argument\n";
+        return 1;
+      }
+    } else if (flag == "--disk-readonly") {
+      diskReadOnly = true;
+    } else if (int parsed = parseBankOption(flag, i, argc, argv, banks); parsed != 0) {
+      if (parsed < 0) {
+        return 1;
+      }
+    } else {
+      std::cerr << "Error: Unknown option '" << flag << "'\n";
+      return 1;
+    }
+  }
+
+  if (inputFile.empty()) {
+    std::cerr << "Error: --input <file> is required for run mode\n";
+    return 1;
+  }
+  if (!validateBankLayout(banks)) {
+    return 1;
+  }
+
+  std::string fileContent;
+  if (!readInputFile(inputFile, fileContent)) {
+    return 1;
+  }
+
+  QCoreApplication application(argc, argv);
+  Processor processor(processorVersion);
+  Core::AssemblyOptions options;
+  options.banks = banks;
+  AssemblyResult status = Assembler::assemble(processorVersion, QString::fromStdString(fileContent), processor.backupMemory, options);
+  if (!status.error.ok) {
+    if (status.error.errorLineNum != -1) {
+      std::cerr << "Error: (line:" << status.error.errorLineNum << ") ";
+    }
+    std::cerr << "Error:" << status.error.message.toStdString();
+    std::cerr << "Assembly failed.\n";
+    return 1;
+  }
+
+  if (!processor.configureBanks(banks)) {
+    std::cerr << "Error: The bank select register at $" << QString::number(BankController::defaultAddress, 16).toUpper().toStdString() << " overlaps another device\n";
+    return 1;
+  }
+  processor.banks.setInitialContents(status.banks);
+  processor.reset();
+  processor.useCycles = useCycles;
+  processor.addAction(Core::Action{Core::ActionType::SETIRQONKEYPRESS, irqOnKey});
+  processor.addAction(Core::Action{Core::ActionType::SETSERIALADDRESS, serialAddress});
+  processor.addAction(Core::Action{Core::ActionType::SETSERIALBAUD, static_cast<uint32_t>(baudRate)});
+  if (processor.serial.address() != serialAddress) {
+    std::cerr << "Error: The ACIA registers at $" << QString::number(serialAddress, 16).toUpper().toStdString() << " would overlap other devices or the interrupt vectors\n";
+    return 1;
+  }
+  if (!diskFile.empty()) {
+    QString error;
+    std::shared_ptr<DiskImage> image = DiskImage::open(QString::fromStdString(diskFile), diskReadOnly, error);
+    if (image == nullptr) {
+      std::cerr << "Error: Unable to open disk image '" << diskFile << "': " << error.toStdString() << "\n";
+      return 1;
+    }
+    processor.storage.insert(image);
+    processor.addAction(Core::Action{Core::ActionType::SETBLOCKIMAGE, 0});
+  }
+  std::signal(SIGINT, interruptHandler);
+
+  SerialHost serialHost(processor.serial);
+  if (serialLine == "stdio") {
+    // the line takes over the terminal, there is no display to draw
+    serialHost.openStandardStreams();
+    processor.startExecution(static_cast<uint32_t>(1000000000 / speed), status.assemblyMap, Core::AddressSet());
+    while (processor.running && !runInterrupted) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    processor.stopExecution();
+    serialHost.close();
+    std::cerr << "\nStopped at PC $" << QString("%1").arg(processor.PC, 4, 16, QChar('0')).toUpper().toStdString() << " after " << processor.operationsSinceStart << " operations.\n";
+    return 0;
+  }
+  std::string statusLine;
+  if (serialLine == "pty") {
+    if (!serialHost.openPseudoTerminal()) {
+      std::cerr << "Error: " << serialHost.errorString().toStdString() << "\n";
+      return 1;
+    }
+    statusLine = "Serial port: " + serialHost.devicePath().toStdString();
+  }
+
+  // the display is only drawn from snapshots, the execution thread is never paused for it
+  auto snapshot = std::make_unique<Core::ProcessorSnapshot>();
+  {
+    TerminalDisplay terminal(statusLine);
+    terminal.draw(processor.Memory);
+    processor.startExecution(static_cast<uint32_t>(1000000000 / speed), status.assemblyMap, Core::AddressSet());
+    const auto frameTime = std::chrono::nanoseconds(1000000000 / framesPerSecond);
+    auto nextFrame = std::chrono::steady_clock::now();
+    while (processor.running && !runInterrupted) {
+      processor.requestSnapshot();
+      nextFrame += frameTime;
+      std::this_thread::sleep_until(nextFrame);
+      if (processor.takeSnapshot(snapshot)) {
+        terminal.draw(snapshot->memory);
+      }
+      for (uint8_t key : terminal.readKeys()) {
+        processor.addAction(Core::Action{Core::ActionType::SETKEY, key});
+      }
+    }
+    processor.stopExecution();
+    terminal.draw(processor.Memory);
+  }
+  std::cout << "Stopped at PC $" << QString("%1").arg(processor.PC, 4, 16, QChar('0')).toUpper().toStdString() << " after " << processor.operationsSinceStart << " operations.\n";
   return 0;
 }
 
@@ -221,6 +546,9 @@ int main(int argc, char* argv[]) {
       if (arg == "--asm" || arg == "--assemble") {
         return handleAssembly(argc, argv);
       }
+      if (arg == "--run") {
+        return handleRun(argc, argv);
+      }
       if (arg == "--version" || arg == "--ver") {
         printVersion();
         return 0;
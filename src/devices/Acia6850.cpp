@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/devices/Acia6850.h"
+
+#include <algorithm>
+
+namespace {
+  // data bits, parity bits and stop bits of the eight word select settings
+  constexpr int wordBits[8] = {7 + 1 + 2, 7 + 1 + 2, 7 + 1 + 1, 7 + 1 + 1, 8 + 2, 8 + 1, 8 + 1 + 1, 8 + 1 + 1};
+} // namespace
+
+void Acia6850::attachTo(DeviceBus &bus, uint16_t address) {
+  bus.detach(*this);
+  bus.attach(*this, address, registerCount);
+  base = address;
+  publish();
+}
+
+void Acia6850::setBaudRate(int baud) {
+  baudRate = std::clamp(baud, 50, clockHz / 16);
+}
+
+/**
+ * @brief Returns to the state after power-up, held in master reset until the program configures it.
+ *
+ * Characters still waiting to be sent to the host are left to the host side, received ones are
+ * dropped.
+ */
+void Acia6850::reset() {
+  control = 0x03;
+  status = 0;
+  receiveData = 0;
+  receiving = false;
+  receiveDoneAt = idle;
+  transmitDoneAt = idle;
+  received.clear();
+  publish();
+}
+
+/**
+ * @brief Returns how long one character takes on the line, start bit included.
+ */
+uint64_t Acia6850::characterCycles() const {
+  static constexpr int divisors[3] = {1, 16, 64};
+  int bits = 1 + wordBits[(control >> 2) & 0x07];
+  return std::max<uint64_t>(1, static_cast<uint64_t>(bits) * clockHz * divisors[control & 0x03] / (16 * static_cast<uint64_t>(baudRate)));
+}
+
+uint8_t Acia6850::dataMask() const {
+  return (control & 0x10) ? 0xFF : 0x7F;
+}
+
+void Acia6850::registerRead(uint16_t address) {
+  if (address == base + 1) {
+    status &= ~(receiveFull | overrun);
+    publish();
+  }
+}
+
+/**
+ * @brief Configures the ACIA or queues a character for transmission.
+ *
+ * Writing 3 to the low control bits is a master reset, any other value releases it. The
+ * transmit data register is moved to the shift register as soon as that one is free.
+ */
+void Acia6850::registerWritten(uint16_t address, uint8_t value) {
+  if (address == base) {
+    bool wasReset = inMasterReset();
+    control = value;
+    if (inMasterReset()) {
+      status = 0;
+      receiving = false;
+      receiveDoneAt = idle;
+      transmitDoneAt = idle;
+    } else if (wasReset) {
+      status |= transmitEmpty;
+      startReceive();
+    }
+  } else if (!inMasterReset()) {
+    transmitData = value & dataMask();
+    status &= ~transmitEmpty;
+    if (transmitDoneAt == idle) {
+      startTransmit();
+    }
+  }
+  publish();
+}
+
+void Acia6850::startTransmit() {
+  transmitShift = transmitData;
+  status |= transmitEmpty;
+  transmitDoneAt = now() + characterCycles();
+}
+
+/**
+ * @brief Starts shifting in the next character from the host, or looks again one character time later.
+ */
+void Acia6850::startReceive() {
+  receiving = received.pop(receiveShift);
+  receiveShift &= dataMask();
+  receiveDoneAt = now() + characterCycles();
+}
+
+/**
+ * @brief Completes the characters whose last bit has been shifted.
+ *
+ * A character received while the previous one was not read yet is lost and reported as an
+ * overrun. A character the host can not take yet stays in the shift register, which holds up
+ * the transmitter like a peer dropping clear to send.
+ */
+void Acia6850::advance() {
+  if (inMasterReset()) {
+    return;
+  }
+  uint64_t time = now();
+  if (transmitDoneAt <= time) {
+    if (transmitted.push(transmitShift)) {
+      transmitDoneAt = idle;
+      if (!(status & transmitEmpty)) {
+        startTransmit();
+      }
+    } else {
+      transmitDoneAt = time + characterCycles();
+    }
+  }
+  if (receiveDoneAt <= time) {
+    if (receiving) {
+      if (status & receiveFull) {
+        status |= overrun;
+      } else {
+        receiveData = receiveShift;
+        status |= receiveFull;
+      }
+    }
+    startReceive();
+  }
+  publish();
+}
+
+/**
+ * @brief Mirrors the status and received data into memory, drives the IRQ line and schedules the next event.
+ */
+void Acia6850::publish() {
+  bool receiveInterrupt = (control & 0x80) && (status & (receiveFull | overrun));
+  bool transmitInterrupt = (control & 0x60) == 0x20 && (status & transmitEmpty);
+  bool interrupt = !inMasterReset() && (receiveInterrupt || transmitInterrupt);
+  status = interrupt ? status | interruptRequest : status & ~interruptRequest;
+  memory[base] = status;
+  memory[base + 1] = receiveData;
+  setInterruptLine(interrupt);
+  schedule(inMasterReset() ? idle : std::min(receiveDoneAt, transmitDoneAt));
+}
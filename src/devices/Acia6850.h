@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ACIA6850_H
+#define ACIA6850_H
+
+#include "src/devices/DeviceBus.h"
+#include "src/utils/RingBuffer.h"
+
+/**
+ * @brief MC6850 asynchronous communications interface adapter.
+ *
+ * Registers at the base address: control (write) and status (read), then transmit data (write)
+ * and receive data (read). Characters take as many cycles as their bits need at the configured
+ * baud rate against a 1 MHz E clock. The baud rate applies to the divide by 16 setting, divide
+ * by 64 is four times slower and divide by 1 sixteen times faster.
+ *
+ * The serial line is a pair of ring buffers, the host side (a console, standard streams or a
+ * pseudo-terminal) fills one and drains the other from its own thread.
+ */
+class Acia6850 final : public IODevice {
+public:
+  static constexpr uint16_t defaultAddress = 0xFFE0;
+  static constexpr int registerCount = 2;
+  static constexpr int defaultBaudRate = 9600;
+  static constexpr int clockHz = 1000000;
+
+  // status register
+  static constexpr uint8_t receiveFull = 0x01;
+  static constexpr uint8_t transmitEmpty = 0x02;
+  static constexpr uint8_t overrun = 0x20;
+  static constexpr uint8_t interruptRequest = 0x80;
+
+  using Line = RingBuffer<uint8_t, 4096>;
+  Line received;    // host to device
+  Line transmitted; // device to host
+
+  using IODevice::IODevice;
+
+  void attachTo(DeviceBus &bus, uint16_t address);
+  uint16_t address() const { return base; }
+  void setBaudRate(int baud);
+
+  void reset() override;
+  void registerRead(uint16_t address) override;
+  void registerWritten(uint16_t address, uint8_t value) override;
+  void advance() override;
+
+private:
+  static constexpr uint64_t idle = std::numeric_limits<uint64_t>::max();
+
+  uint16_t base = defaultAddress;
+  int baudRate = defaultBaudRate;
+  uint8_t control = 0x03;
+  uint8_t status = 0;
+  uint8_t receiveData = 0;
+  uint8_t receiveShift = 0;
+  bool receiving = false;
+  uint64_t receiveDoneAt = idle; // end of the character being received, or the next look at the line
+  uint8_t transmitData = 0;
+  uint8_t transmitShift = 0;
+  uint64_t transmitDoneAt = idle;
+
+  bool inMasterReset() const { return (control & 0x03) == 0x03; }
+  uint64_t characterCycles() const;
+  uint8_t dataMask() const;
+  void startTransmit();
+  void startReceive();
+  void publish();
+};
+
+#endif // ACIA6850_H
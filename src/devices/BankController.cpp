@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/devices/BankController.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Sets up the window and backing store, or turns banking off for a layout without banks.
+ *
+ * The window keeps its current contents as bank 0, the other banks start out cleared.
+ */
+void BankController::configure(DeviceBus &bus, const Core::BankLayout &newLayout) {
+  bus.detach(*this);
+  bankLayout = newLayout;
+  store.assign(static_cast<size_t>(bankLayout.bankCount) * bankLayout.windowSize, 0);
+  initialStore = store;
+  pageTable.fill(nullptr);
+  mappedPage = nullptr;
+  selected = 0;
+  if (!bankLayout.enabled()) {
+    return;
+  }
+  for (size_t value = 0; value < pageTable.size(); ++value) {
+    pageTable[value] = store.data() + value % bankLayout.bankCount * bankLayout.windowSize;
+  }
+  mappedPage = pageTable[0];
+  bus.attach(*this, defaultAddress, registerCount);
+  memory[defaultAddress] = 0;
+}
+
+/**
+ * @brief Replaces the contents the banks other than bank 0 are given on reset, and maps bank 0.
+ *
+ * Bank 0 is restored from the window of the memory image, like memory outside the window.
+ */
+void BankController::setInitialContents(const std::map<int, std::vector<uint8_t>> &banks) {
+  if (!bankLayout.enabled()) {
+    return;
+  }
+  std::fill(initialStore.begin(), initialStore.end(), 0);
+  for (const auto &[bank, bytes] : banks) {
+    if (bank > 0 && bank < bankLayout.bankCount) {
+      std::memcpy(initialStore.data() + static_cast<size_t>(bank) * bankLayout.windowSize, bytes.data(), std::min<size_t>(bytes.size(), bankLayout.windowSize));
+    }
+  }
+  reset();
+}
+
+/**
+ * @brief Returns the contents of a bank, taken from the window while it is mapped.
+ */
+std::vector<uint8_t> BankController::contents(int bank) const {
+  const uint8_t *page = bank == selected ? memory.data() + bankLayout.windowStart : pageTable[bank];
+  return std::vector<uint8_t>(page, page + bankLayout.windowSize);
+}
+
+/**
+ * @brief Restores the banks and maps bank 0, called after memory has been restored.
+ */
+void BankController::reset() {
+  if (!bankLayout.enabled()) {
+    return;
+  }
+  std::copy(initialStore.begin(), initialStore.end(), store.begin()); // the page table points into store
+  mappedPage = pageTable[0];
+  selected = 0;
+  memory[defaultAddress] = 0;
+}
+
+void BankController::registerWritten(uint16_t /*address*/, uint8_t value) {
+  select(value);
+}
+
+/**
+ * @brief Maps a bank by exchanging the window with its page.
+ *
+ * The page table lookup is constant time, the exchange costs two copies of the window.
+ */
+void BankController::select(int bank) {
+  uint8_t *page = pageTable[bank];
+  uint8_t *window = memory.data() + bankLayout.windowStart;
+  if (page != mappedPage) {
+    std::memcpy(mappedPage, window, bankLayout.windowSize);
+    std::memcpy(window, page, bankLayout.windowSize);
+    mappedPage = page;
+  }
+  selected = bank % bankLayout.bankCount;
+  memory[defaultAddress] = static_cast<uint8_t>(bank);
+}
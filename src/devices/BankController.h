@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BANKCONTROLLER_H
+#define BANKCONTROLLER_H
+
+#include "src/devices/DeviceBus.h"
+
+#include <map>
+#include <vector>
+
+/**
+ * @brief Maps one bank of a backing store larger than the address space into a window of memory.
+ *
+ * Writing the bank select register maps the bank, reading it returns the mapped bank. A page
+ * table gives the backing store page of every value the register can hold, values past the last
+ * bank wrap around like an incompletely decoded address.
+ *
+ * The window itself holds the mapped bank, its page in the backing store is only brought up to
+ * date when another bank is selected. Instructions therefore keep accessing memory directly.
+ */
+class BankController final : public IODevice {
+public:
+  static constexpr uint16_t defaultAddress = 0xFFE4;
+  static constexpr int registerCount = 1;
+
+  using IODevice::IODevice;
+
+  void configure(DeviceBus &bus, const Core::BankLayout &newLayout);
+  const Core::BankLayout &layout() const { return bankLayout; }
+  int selectedBank() const { return selected; }
+
+  void setInitialContents(const std::map<int, std::vector<uint8_t>> &banks);
+  std::vector<uint8_t> contents(int bank) const;
+
+  void reset() override;
+  void registerWritten(uint16_t address, uint8_t value) override;
+
+private:
+  Core::BankLayout bankLayout;
+  std::vector<uint8_t> store;        // one page per bank
+  std::vector<uint8_t> initialStore; // the store as assembled or loaded, restored on reset
+  std::array<uint8_t *, 256> pageTable = {};
+  uint8_t *mappedPage = nullptr;
+  int selected = 0;
+
+  void select(int bank);
+};
+
+#endif // BANKCONTROLLER_H
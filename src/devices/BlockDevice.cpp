@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/devices/BlockDevice.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Maps an image file, read-write unless asked for read-only or the file can only be read.
+ *
+ * A partial sector at the end of the file is not used, nor is anything past the last sector a
+ * sector number can reach.
+ *
+ * @return The image, or nullptr with the reason in error.
+ */
+std::shared_ptr<DiskImage> DiskImage::open(const QString &path, bool readOnly, QString &error) {
+  auto image = std::make_shared<DiskImage>();
+  image->file.setFileName(path);
+  if (!readOnly && !image->file.open(QIODevice::ReadWrite)) {
+    readOnly = true;
+  }
+  if (readOnly && !image->file.open(QIODevice::ReadOnly)) {
+    error = image->file.errorString();
+    return nullptr;
+  }
+  qint64 sectors = std::min<qint64>(image->file.size() / sectorSize, maxSectors);
+  if (sectors == 0) {
+    error = QString("The image is smaller than one sector of %1 bytes.").arg(sectorSize);
+    return nullptr;
+  }
+  image->data = image->file.map(0, sectors * sectorSize);
+  if (image->data == nullptr) {
+    error = image->file.errorString();
+    return nullptr;
+  }
+  image->sectors = static_cast<int>(sectors);
+  image->readOnly = readOnly;
+  return image;
+}
+
+void BlockDevice::attachTo(DeviceBus &bus) {
+  bus.attach(*this, base, registerCount);
+  publish();
+}
+
+/**
+ * @brief Hands an image, or nullptr to eject the current one, over to the execution thread.
+ */
+void BlockDevice::insert(std::shared_ptr<DiskImage> newImage) {
+  QMutexLocker locker(&insertMutex);
+  inserted = std::move(newImage);
+}
+
+/**
+ * @brief Takes the image handed over by insert into use, a transfer in progress completes with it.
+ */
+void BlockDevice::loadInserted() {
+  {
+    QMutexLocker locker(&insertMutex);
+    image = std::move(inserted);
+  }
+  publish();
+}
+
+/**
+ * @brief Abandons any transfer and returns the registers to their power-up values, the image stays.
+ */
+void BlockDevice::reset() {
+  command = 0;
+  status = 0;
+  sectorNumber = 0;
+  transferAddress = defaultTransferAddress;
+  sectorCount = 1;
+  publish();
+}
+
+void BlockDevice::registerRead(uint16_t address) {
+  if (address == base && (status & interruptRequest)) {
+    status &= ~interruptRequest;
+    publish();
+  }
+}
+
+/**
+ * @brief Latches the transfer parameters or starts a command.
+ *
+ * Commands written while a transfer is in progress are ignored. The status register reports
+ * busy until the transfer time has passed.
+ */
+void BlockDevice::registerWritten(uint16_t address, uint8_t value) {
+  switch (address - base) {
+  case 0:
+    if (!(status & busy)) {
+      command = value;
+      status &= ~(error | interruptRequest);
+      if (command & (readCommand | writeCommand)) {
+        status |= busy;
+        schedule(now() + commandCycles + static_cast<uint64_t>(sectorCount) * sectorCycles);
+      }
+    }
+    break;
+  case 1:
+    sectorNumber = (sectorNumber & 0x00FF) | (value << 8);
+    break;
+  case 2:
+    sectorNumber = (sectorNumber & 0xFF00) | value;
+    break;
+  case 3:
+    transferAddress = (transferAddress & 0x00FF) | (value << 8);
+    break;
+  case 4:
+    transferAddress = (transferAddress & 0xFF00) | value;
+    break;
+  case 5:
+    sectorCount = value;
+    break;
+  }
+  publish();
+}
+
+/**
+ * @brief Completes the transfer and requests the completion interrupt if the command enabled it.
+ */
+void BlockDevice::advance() {
+  if (!(status & busy)) {
+    return;
+  }
+  status &= ~busy;
+  if (transfer()) {
+    sectorNumber += sectorCount;
+  } else {
+    status |= error;
+  }
+  if (command & interruptEnable) {
+    status |= interruptRequest;
+  }
+  publish();
+}
+
+/**
+ * @brief Copies the sectors of the current command between the image and memory.
+ *
+ * Nothing is copied when any part of the transfer is invalid: both read and write requested, no
+ * image, sectors past its end, writing a read-only image, or memory reaching into the device
+ * registers.
+ *
+ * @return Whether the sectors were copied.
+ */
+bool BlockDevice::transfer() {
+  int bytes = sectorCount * DiskImage::sectorSize;
+  if ((command & readCommand) && (command & writeCommand)) {
+    return false;
+  }
+  if (image == nullptr || sectorCount == 0 || sectorNumber + sectorCount > image->sectorCount()) {
+    return false;
+  }
+  if (transferAddress + bytes > Core::deviceRegistersStart) {
+    return false;
+  }
+  if (command & readCommand) {
+    std::memcpy(memory.data() + transferAddress, image->sector(sectorNumber), bytes);
+    return true;
+  }
+  if (image->isReadOnly()) {
+    return false;
+  }
+  std::memcpy(image->sector(sectorNumber), memory.data() + transferAddress, bytes);
+  return true;
+}
+
+/**
+ * @brief Mirrors the registers into memory and drives the IRQ line.
+ */
+void BlockDevice::publish() {
+  status &= ~(ready | writeProtected);
+  if (image != nullptr) {
+    status |= image->isReadOnly() ? ready | writeProtected : ready;
+  }
+  memory[base] = status;
+  memory[base + 1] = sectorNumber >> 8;
+  memory[base + 2] = sectorNumber & 0xFF;
+  memory[base + 3] = transferAddress >> 8;
+  memory[base + 4] = transferAddress & 0xFF;
+  memory[base + 5] = sectorCount;
+  setInterruptLine(status & interruptRequest);
+}
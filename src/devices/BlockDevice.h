@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BLOCKDEVICE_H
+#define BLOCKDEVICE_H
+
+#include "src/devices/DeviceBus.h"
+
+#include <QFile>
+#include <QMutex>
+
+#include <memory>
+
+/**
+ * @brief A host file mapped into memory and divided into sectors.
+ *
+ * The file is not read up front, the operating system pages in the sectors that are used and
+ * writes changed ones back to the file.
+ */
+class DiskImage {
+public:
+  static constexpr int sectorSize = 256;
+  static constexpr int maxSectors = 0x10000; // sector numbers are 16 bits
+
+  static std::shared_ptr<DiskImage> open(const QString &path, bool readOnly, QString &error);
+
+  uint8_t *sector(int index) const { return data + static_cast<qint64>(index) * sectorSize; }
+  int sectorCount() const { return sectors; }
+  bool isReadOnly() const { return readOnly; }
+  QString path() const { return file.fileName(); }
+
+private:
+  QFile file;
+  uint8_t *data = nullptr;
+  int sectors = 0;
+  bool readOnly = true;
+};
+
+/**
+ * @brief Block storage controller copying whole sectors between a disk image and memory.
+ *
+ * Registers at the base address: command (write) and status (read), sector number (high and low
+ * byte), transfer address (high and low byte) and sector count. A command copies the sectors in
+ * one go once the transfer time has passed, the sector number then points past the transferred
+ * sectors so consecutive commands stream through the image.
+ *
+ * The image is handed over from the UI thread with insert and comes into use when the processor
+ * handles the SETBLOCKIMAGE action.
+ */
+class BlockDevice final : public IODevice {
+public:
+  static constexpr uint16_t defaultAddress = 0xFFE8;
+  static constexpr int registerCount = 6;
+  static constexpr uint16_t defaultTransferAddress = 0xF500;
+  static constexpr int commandCycles = 100;
+  static constexpr int sectorCycles = DiskImage::sectorSize; // one byte per cycle, like DMA
+
+  // command register
+  static constexpr uint8_t readCommand = 0x01;
+  static constexpr uint8_t writeCommand = 0x02;
+  static constexpr uint8_t interruptEnable = 0x80;
+
+  // status register
+  static constexpr uint8_t busy = 0x01;
+  static constexpr uint8_t error = 0x02;
+  static constexpr uint8_t writeProtected = 0x10;
+  static constexpr uint8_t ready = 0x40;
+  static constexpr uint8_t interruptRequest = 0x80;
+
+  using IODevice::IODevice;
+
+  void attachTo(DeviceBus &bus);
+  void insert(std::shared_ptr<DiskImage> image);
+  void loadInserted();
+
+  void reset() override;
+  void registerRead(uint16_t address) override;
+  void registerWritten(uint16_t address, uint8_t value) override;
+  void advance() override;
+
+private:
+  static constexpr uint16_t base = defaultAddress;
+
+  QMutex insertMutex;
+  std::shared_ptr<DiskImage> inserted; // guarded by insertMutex
+  std::shared_ptr<DiskImage> image;
+  uint8_t command = 0;
+  uint8_t status = 0;
+  uint16_t sectorNumber = 0;
+  uint16_t transferAddress = defaultTransferAddress;
+  uint8_t sectorCount = 1;
+
+  bool transfer();
+  void publish();
+};
+
+#endif // BLOCKDEVICE_H
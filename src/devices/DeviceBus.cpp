@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/devices/DeviceBus.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Drives the device's IRQ line, the processor takes the interrupt while any line is asserted.
+ */
+void IODevice::setInterruptLine(bool level) {
+  if (level == interruptLine) {
+    return;
+  }
+  interruptLine = level;
+  if (attachedBus != nullptr) {
+    attachedBus->assertedLines += level ? 1 : -1;
+  }
+}
+
+uint64_t IODevice::now() const {
+  return attachedBus != nullptr ? attachedBus->clock : 0;
+}
+
+/**
+ * @brief Asks for advance to be called once the bus clock reaches the cycle, replacing an earlier request.
+ */
+void IODevice::schedule(uint64_t cycle) {
+  scheduledAt = cycle;
+  if (attachedBus != nullptr && cycle < attachedBus->nextEvent) {
+    attachedBus->nextEvent = cycle;
+  }
+}
+
+/**
+ * @brief Maps a range of the device register window to a device.
+ *
+ * @throws std::invalid_argument If the range leaves the window or overlaps another device.
+ */
+void DeviceBus::attach(IODevice &device, uint16_t firstRegister, int registerCount) {
+  if (!inWindow(firstRegister) || firstRegister + registerCount > Core::deviceRegistersEnd) {
+    throw std::invalid_argument("Device registers outside of the device register window.");
+  }
+  if (!isFree(firstRegister, registerCount, &device)) {
+    throw std::invalid_argument("Device registers overlap another device.");
+  }
+  for (int i = 0; i < registerCount; ++i) {
+    owners[firstRegister - Core::deviceRegistersStart + i] = &device;
+  }
+  if (std::find(devices.begin(), devices.end(), &device) == devices.end()) {
+    devices.push_back(&device);
+    device.attachedBus = this;
+    if (device.interruptLine) {
+      assertedLines++;
+    }
+  }
+}
+
+/**
+ * @brief Unmaps every register of the device, it stays attached for reset and its events.
+ */
+void DeviceBus::detach(const IODevice &device) {
+  for (IODevice *&owner : owners) {
+    if (owner == &device) {
+      owner = nullptr;
+    }
+  }
+}
+
+/**
+ * @brief Returns whether the registers lie in the window and belong to no device other than the given one.
+ */
+bool DeviceBus::isFree(uint16_t firstRegister, int registerCount, const IODevice *except) const {
+  if (!inWindow(firstRegister) || firstRegister + registerCount > Core::deviceRegistersEnd) {
+    return false;
+  }
+  for (int i = 0; i < registerCount; ++i) {
+    const IODevice *owner = owners[firstRegister - Core::deviceRegistersStart + i];
+    if (owner != nullptr && owner != except) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Calls advance of every device whose event is due and finds the next event.
+ */
+void DeviceBus::runEvents() {
+  nextEvent = std::numeric_limits<uint64_t>::max();
+  for (IODevice *device : devices) {
+    if (device->scheduledAt <= clock) {
+      device->scheduledAt = std::numeric_limits<uint64_t>::max();
+      device->advance();
+    }
+  }
+  for (IODevice *device : devices) {
+    nextEvent = std::min(nextEvent, device->scheduledAt);
+  }
+}
+
+/**
+ * @brief Resets every attached device, called after memory has been restored.
+ *
+ * The devices write their reset values over the registers they own, so the window no longer holds
+ * the restored bytes. The assembler warns about code placed there.
+ */
+void DeviceBus::reset() {
+  nextEvent = std::numeric_limits<uint64_t>::max();
+  for (IODevice *device : devices) {
+    device->scheduledAt = std::numeric_limits<uint64_t>::max();
+    device->reset();
+  }
+}
+
+/**
+ * @brief Reports an instruction's access of one or two bytes to the devices owning them.
+ *
+ * Read-modify-write instructions report the read before the write. The written bytes are taken
+ * before any device reacts, since that may already put new values in its registers.
+ */
+void DeviceBus::access(uint16_t address, int width, bool read, bool write) {
+  std::array<IODevice *, 2> accessed = {};
+  std::array<uint8_t, 2> values = {};
+  for (int i = 0; i < width; ++i) {
+    uint16_t registerAddress = (address + i) & 0xFFFF;
+    if (inWindow(registerAddress)) {
+      accessed[i] = owners[registerAddress - Core::deviceRegistersStart];
+      values[i] = accessed[i] != nullptr ? accessed[i]->memory[registerAddress] : 0;
+    }
+  }
+  for (int i = 0; i < width; ++i) {
+    if (accessed[i] == nullptr) {
+      continue;
+    }
+    uint16_t registerAddress = (address + i) & 0xFFFF;
+    if (read) {
+      accessed[i]->registerRead(registerAddress);
+    }
+    if (write) {
+      accessed[i]->registerWritten(registerAddress, values[i]);
+    }
+  }
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DEVICEBUS_H
+#define DEVICEBUS_H
+
+#include "src/core/Core.h"
+
+#include <array>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+class DeviceBus;
+
+/**
+ * @brief A peripheral whose registers live in the device register window of memory.
+ *
+ * Instructions read and write the registers in memory directly, the device keeps them up to
+ * date and is told about every access once the instruction completes.
+ *
+ * Devices with their own timing schedule events on the bus clock, which counts processor
+ * cycles. advance is called once the clock reaches the scheduled time.
+ */
+class IODevice {
+public:
+  explicit IODevice(std::array<uint8_t, 0x10000> &mem) : memory(mem) {}
+  virtual ~IODevice() = default;
+
+  virtual void reset() = 0;
+  virtual void registerRead(uint16_t /*address*/) {}
+  virtual void registerWritten(uint16_t /*address*/, uint8_t /*value*/) {}
+  virtual void advance() {}
+
+  bool interruptRequested() const { return interruptLine; }
+
+protected:
+  std::array<uint8_t, 0x10000> &memory;
+
+  void setInterruptLine(bool level);
+  uint64_t now() const;
+  void schedule(uint64_t cycle);
+
+private:
+  friend class DeviceBus;
+  DeviceBus *attachedBus = nullptr;
+  bool interruptLine = false;
+  uint64_t scheduledAt = std::numeric_limits<uint64_t>::max();
+};
+
+/**
+ * @brief Routes instruction accesses in the device register window to the devices owning them.
+ *
+ * The window is ordinary memory taken over by the devices, anything assembled or loaded into
+ * it is replaced by the register values on reset.
+ *
+ * The IRQ lines of all devices are wired together, the bus only counts how many are asserted.
+ */
+class DeviceBus {
+public:
+  void attach(IODevice &device, uint16_t firstRegister, int registerCount);
+  void detach(const IODevice &device);
+  bool isFree(uint16_t firstRegister, int registerCount, const IODevice *except = nullptr) const;
+  void reset();
+  void access(uint16_t address, int width, bool read, bool write);
+  bool interruptAsserted() const { return assertedLines != 0; }
+
+  // advances the clock by the cycles of one instruction, cheap unless an event is due
+  void tick(int cycles) {
+    clock += cycles;
+    if (clock >= nextEvent) {
+      runEvents();
+    }
+  }
+
+  static bool inWindow(int address) { return address >= Core::deviceRegistersStart && address < Core::deviceRegistersEnd; }
+
+private:
+  friend class IODevice;
+  std::array<IODevice *, Core::deviceRegistersEnd - Core::deviceRegistersStart> owners = {};
+  std::vector<IODevice *> devices;
+  int assertedLines = 0;
+  uint64_t clock = 0;
+  uint64_t nextEvent = std::numeric_limits<uint64_t>::max();
+
+  void runEvents();
+};
+
+#endif // DEVICEBUS_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/devices/KeyboardController.h"
+
+void KeyboardController::attachTo(DeviceBus &bus) {
+  bus.attach(*this, dataRegister, 1);
+  bus.attach(*this, statusRegister, 1);
+}
+
+void KeyboardController::reset() {
+  head = 0;
+  count = 0;
+  current = 0;
+  unread = false;
+  status = 0;
+  control = 0;
+  publishStatus();
+}
+
+/**
+ * @brief Buffers a key press, the key goes straight to the data register if that one was read.
+ *
+ * A key arriving while the FIFO is full is dropped and reported through the overrun bit.
+ */
+void KeyboardController::pressKey(uint8_t key) {
+  if (!unread) {
+    current = key;
+    memory[dataRegister] = current;
+    unread = true;
+  } else if (count < fifoSize) {
+    fifo[(head + count) % fifoSize] = key;
+    count++;
+  } else {
+    status |= overrun;
+  }
+  publishStatus();
+}
+
+void KeyboardController::registerRead(uint16_t address) {
+  if (address == dataRegister && unread) {
+    if (count > 0) {
+      current = fifo[head];
+      memory[dataRegister] = current;
+      head = (head + 1) % fifoSize;
+      count--;
+    } else {
+      unread = false;
+    }
+  } else if (address == statusRegister) {
+    status &= ~overrun;
+  }
+  publishStatus();
+}
+
+void KeyboardController::registerWritten(uint16_t address, uint8_t value) {
+  if (address == dataRegister) {
+    if (unread) {
+      // the key has not been read yet, the write must not destroy it
+      memory[dataRegister] = current;
+    }
+    return;
+  }
+  control = value & interruptEnable;
+  publishStatus();
+}
+
+void KeyboardController::publishStatus() {
+  status = (status & overrun) | (unread ? keyAvailable : 0);
+  memory[statusRegister] = status | control;
+  setInterruptLine((control & interruptEnable) && unread);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef KEYBOARDCONTROLLER_H
+#define KEYBOARDCONTROLLER_H
+
+#include "src/devices/DeviceBus.h"
+
+/**
+ * @brief Keyboard controller buffering key presses in a FIFO.
+ *
+ * Data register ($FFF0): the oldest unread key, reading it consumes the key and moves the next
+ * one in. Without an unread key it keeps its last value and may be written freely, so programs
+ * clearing it to acknowledge a key keep working.
+ *
+ * Status register ($FFF4): bit 0 set while a key is unread, bit 1 set when a key was lost to a
+ * full FIFO since the status was last read, bit 7 the interrupt enable. Only bit 7 is writable,
+ * with it set the IRQ line is held while a key is unread.
+ */
+class KeyboardController final : public IODevice {
+public:
+  static constexpr uint16_t dataRegister = 0xFFF0;
+  static constexpr uint16_t statusRegister = 0xFFF4;
+  static constexpr int fifoSize = 16;
+
+  static constexpr uint8_t keyAvailable = 0x01;
+  static constexpr uint8_t overrun = 0x02;
+  static constexpr uint8_t interruptEnable = 0x80;
+
+  using IODevice::IODevice;
+
+  void attachTo(DeviceBus &bus);
+  void reset() override;
+  void registerRead(uint16_t address) override;
+  void registerWritten(uint16_t address, uint8_t value) override;
+
+  void pressKey(uint8_t key);
+
+private:
+  std::array<uint8_t, fifoSize> fifo = {};
+  int head = 0;
+  int count = 0; // keys waiting behind the one in the data register
+  uint8_t current = 0;
+  bool unread = false;
+  uint8_t status = 0;
+  uint8_t control = 0;
+
+  void publishStatus();
+};
+
+#endif // KEYBOARDCONTROLLER_H
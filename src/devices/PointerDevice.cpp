@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/devices/PointerDevice.h"
+
+#include <algorithm>
+
+void PointerDevice::attachTo(DeviceBus &bus) {
+  bus.attach(*this, clickRegister, 3);
+  bus.attach(*this, wheelRegister, 2);
+}
+
+/**
+ * @brief Forgets buffered clicks and wheel steps, the position and held buttons are sampled again.
+ */
+void PointerDevice::reset() {
+  pendingClick.store(0, std::memory_order_relaxed);
+  pendingAngleDelta.store(0, std::memory_order_relaxed);
+  angleRemainder = 0;
+  wheelSteps = 0;
+  memory[wheelRegister] = 0;
+  sample();
+}
+
+void PointerDevice::registerRead(uint16_t address) {
+  if (address == wheelRegister) {
+    wheelSteps = 0;
+    memory[wheelRegister] = 0;
+  }
+}
+
+void PointerDevice::setPosition(uint8_t x, uint8_t y) {
+  uint32_t state = publishedState.load(std::memory_order_relaxed);
+  uint32_t updated;
+  do {
+    updated = (state & 0xFF0000) | (y << 8) | x;
+  } while (!publishedState.compare_exchange_weak(state, updated, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void PointerDevice::setButtons(uint8_t buttons) {
+  uint32_t state = publishedState.load(std::memory_order_relaxed);
+  uint32_t updated;
+  do {
+    updated = (state & 0xFFFF) | (buttons << 16);
+  } while (!publishedState.compare_exchange_weak(state, updated, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void PointerDevice::click(uint8_t button) {
+  pendingClick.store(button, std::memory_order_release);
+}
+
+/**
+ * @brief Adds wheel rotation in eighths of a degree, as reported by Qt.
+ *
+ * Partial steps of high resolution wheels and touchpads are summed until they make a whole step.
+ */
+void PointerDevice::scroll(int angleDelta) {
+  pendingAngleDelta.fetch_add(angleDelta, std::memory_order_release);
+}
+
+/**
+ * @brief Copies the published pointer state into the registers.
+ *
+ * A click is latched into its register only once, so a program clearing the register sees the
+ * next click and not the same one again. Wheel steps saturate at the range of a signed byte.
+ */
+void PointerDevice::sample() {
+  uint32_t state = publishedState.load(std::memory_order_acquire);
+  memory[xRegister] = state & 0xFF;
+  memory[yRegister] = (state >> 8) & 0xFF;
+  memory[buttonsRegister] = (state >> 16) & 0xFF;
+
+  uint8_t button = pendingClick.exchange(0, std::memory_order_acquire);
+  if (button != 0) {
+    memory[clickRegister] = button;
+  }
+
+  angleRemainder += pendingAngleDelta.exchange(0, std::memory_order_acquire);
+  int steps = angleRemainder / angleDeltaPerStep;
+  if (steps != 0) {
+    angleRemainder -= steps * angleDeltaPerStep;
+    wheelSteps = std::clamp(wheelSteps + steps, -128, 127);
+    memory[wheelRegister] = static_cast<uint8_t>(wheelSteps);
+  }
+}
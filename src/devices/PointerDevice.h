@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef POINTERDEVICE_H
+#define POINTERDEVICE_H
+
+#include "src/devices/DeviceBus.h"
+
+#include <atomic>
+
+/**
+ * @brief Pointer input of the displays.
+ *
+ * The UI thread publishes the pointer state into atomics and never touches memory, the
+ * execution thread copies it into the registers when it samples the device at the start of
+ * every batch and before every single step.
+ *
+ * Registers: $FFF1 the last clicked button (1 left, 2 right, 3 middle), kept until the program
+ * clears it. $FFF2 and $FFF3 the pointer column and row. $FFF5 the wheel steps since the register
+ * was last read as a signed byte, positive away from the user, reading it clears it. $FFF6 the
+ * buttons held down, bit 0 left, bit 1 right, bit 2 middle.
+ */
+class PointerDevice final : public IODevice {
+public:
+  static constexpr uint16_t clickRegister = 0xFFF1;
+  static constexpr uint16_t xRegister = 0xFFF2;
+  static constexpr uint16_t yRegister = 0xFFF3;
+  static constexpr uint16_t wheelRegister = 0xFFF5;
+  static constexpr uint16_t buttonsRegister = 0xFFF6;
+
+  static constexpr uint8_t leftButton = 0x01;
+  static constexpr uint8_t rightButton = 0x02;
+  static constexpr uint8_t middleButton = 0x04;
+
+  using IODevice::IODevice;
+
+  void attachTo(DeviceBus &bus);
+  void reset() override;
+  void registerRead(uint16_t address) override;
+
+  // called from the UI thread
+  void setPosition(uint8_t x, uint8_t y);
+  void setButtons(uint8_t buttons);
+  void click(uint8_t button);
+  void scroll(int angleDelta);
+
+  // called from the execution thread
+  void sample();
+
+private:
+  static constexpr int angleDeltaPerStep = 120;
+
+  std::atomic<uint32_t> publishedState = 0; // x, y and held buttons, one byte each
+  std::atomic<uint8_t> pendingClick = 0;
+  std::atomic<int> pendingAngleDelta = 0;
+
+  int angleRemainder = 0;
+  int wheelSteps = 0;
+};
+
+#endif // POINTERDEVICE_H
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/dialogs/CharacterDisplay.h"
+
+#include <QFontMetricsF>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QtMath>
+
+#include <algorithm>
+
+namespace {
+  constexpr int borderWidth = 3;
+  constexpr int atlasColumns = 16;
+  constexpr int basePointSize = 11;
+
+  QFont displayFont(qreal pointSize) {
+    QFont font("Courier New");
+    font.setBold(true);
+    font.setPointSizeF(pointSize);
+    return font;
+  }
+} // namespace
+
+CharacterDisplay::CharacterDisplay(QWidget *parent) : QWidget(parent) {
+  setFocusPolicy(Qt::StrongFocus);
+  setAttribute(Qt::WA_OpaquePaintEvent);
+  buildGlyphAtlas();
+}
+
+/**
+ * @brief Copies the display buffer out of memory and schedules a repaint of the changed cells.
+ *
+ * Changed cells of a row are repainted as one rectangle, Qt merges the rectangles of all rows
+ * into a single paint event.
+ */
+void CharacterDisplay::setMemory(const std::array<uint8_t, 0x10000> &memory) {
+  for (int row = 0; row < rows; ++row) {
+    int firstChanged = -1;
+    int lastChanged = -1;
+    for (int column = 0; column < columns; ++column) {
+      uint8_t value = memory[bufferStart + row * columns + column];
+      uint8_t &cell = cells[row * columns + column];
+      if (cell != value) {
+        cell = value;
+        if (firstChanged == -1) {
+          firstChanged = column;
+        }
+        lastChanged = column;
+      }
+    }
+    if (firstChanged != -1) {
+      update(cellRect(firstChanged, row).united(cellRect(lastChanged, row)));
+    }
+  }
+}
+
+/**
+ * @brief Returns the column and row of the cell under a widget position, clamped to the grid.
+ */
+QPoint CharacterDisplay::cellAt(const QPoint &position) const {
+  QPoint local = position - origin;
+  return QPoint(std::clamp(local.x() / cellSize.width(), 0, columns - 1), std::clamp(local.y() / cellSize.height(), 0, rows - 1));
+}
+
+QSize CharacterDisplay::sizeHint() const {
+  QFontMetricsF metrics(displayFont(basePointSize));
+  return QSize(qCeil(metrics.averageCharWidth() * columns), qCeil(metrics.height() * rows)) + QSize(borderWidth * 2, borderWidth * 2);
+}
+
+/**
+ * @brief Renders every glyph once at the current cell size.
+ *
+ * Cells keep the proportions of the base font and are made as large as the widget allows, so
+ * resizing the widget only rebuilds this pixmap and never lays out any text.
+ */
+void CharacterDisplay::buildGlyphAtlas() {
+  QFontMetricsF baseMetrics(displayFont(basePointSize));
+  qreal availableWidth = std::max(1, width() - borderWidth * 2) / (baseMetrics.averageCharWidth() * columns);
+  qreal availableHeight = std::max(1, height() - borderWidth * 2) / (baseMetrics.height() * rows);
+  qreal scale = std::min(availableWidth, availableHeight);
+
+  cellSize = QSize(std::max(1, static_cast<int>(baseMetrics.averageCharWidth() * scale)), std::max(1, static_cast<int>(baseMetrics.height() * scale)));
+  origin = QPoint((width() - cellSize.width() * columns) / 2, (height() - cellSize.height() * rows) / 2);
+
+  qreal ratio = devicePixelRatioF();
+  glyphAtlas = QPixmap(QSize(cellSize.width() * atlasColumns, cellSize.height() * (256 / atlasColumns)) * ratio);
+  glyphAtlas.setDevicePixelRatio(ratio);
+  glyphAtlas.fill(Qt::black);
+
+  QPainter painter(&glyphAtlas);
+  painter.setFont(displayFont(std::max<qreal>(1, basePointSize * scale)));
+  painter.setPen(Qt::white);
+  for (int value = 0; value < 256; ++value) {
+    QChar character = Core::numToChar(static_cast<uint8_t>(value));
+    if (!character.isNull()) {
+      QRect glyphRect(QPoint(value % atlasColumns * cellSize.width(), value / atlasColumns * cellSize.height()), cellSize);
+      painter.drawText(glyphRect, Qt::AlignCenter, QString(character));
+    }
+  }
+}
+
+QRect CharacterDisplay::cellRect(int column, int row) const {
+  return QRect(origin + QPoint(column * cellSize.width(), row * cellSize.height()), cellSize);
+}
+
+void CharacterDisplay::paintEvent(QPaintEvent *event) {
+  QPainter painter(this);
+  painter.fillRect(event->rect(), Qt::black);
+
+  QRect dirty = event->rect().translated(-origin);
+  int firstColumn = std::max(0, dirty.left() / cellSize.width());
+  int lastColumn = std::min(columns - 1, dirty.right() / cellSize.width());
+  int firstRow = std::max(0, dirty.top() / cellSize.height());
+  int lastRow = std::min(rows - 1, dirty.bottom() / cellSize.height());
+  qreal ratio = glyphAtlas.devicePixelRatio();
+  for (int row = firstRow; row <= lastRow; ++row) {
+    for (int column = firstColumn; column <= lastColumn; ++column) {
+      uint8_t value = cells[row * columns + column];
+      if (Core::numToChar(value).isNull()) {
+        continue;
+      }
+      QRectF source(value % atlasColumns * cellSize.width() * ratio, value / atlasColumns * cellSize.height() * ratio, cellSize.width() * ratio, cellSize.height() * ratio);
+      painter.drawPixmap(QRectF(cellRect(column, row)), glyphAtlas, source);
+    }
+  }
+
+  if (hasFocus()) {
+    painter.setPen(QPen(Qt::blue, borderWidth));
+    painter.drawRect(rect().adjusted(1, 1, -2, -2));
+  }
+}
+
+void CharacterDisplay::resizeEvent(QResizeEvent *event) {
+  QWidget::resizeEvent(event);
+  buildGlyphAtlas();
+}
+
+void CharacterDisplay::focusInEvent(QFocusEvent *event) {
+  QWidget::focusInEvent(event);
+  update();
+}
+
+void CharacterDisplay::focusOutEvent(QFocusEvent *event) {
+  QWidget::focusOutEvent(event);
+  update();
+}
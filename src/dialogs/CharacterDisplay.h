@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CHARACTERDISPLAY_H
+#define CHARACTERDISPLAY_H
+
+#include "src/core/Core.h"
+
+#include <QPixmap>
+#include <QWidget>
+
+#include <array>
+#include <stdint.h>
+
+class CharacterDisplay final : public QWidget {
+  Q_OBJECT
+
+public:
+  static constexpr int columns = Core::displayColumns;
+  static constexpr int rows = Core::displayRows;
+  static constexpr uint16_t bufferStart = Core::displayBufferStart;
+
+  explicit CharacterDisplay(QWidget *parent = nullptr);
+
+  void setMemory(const std::array<uint8_t, 0x10000> &memory);
+  QPoint cellAt(const QPoint &position) const;
+  QSize sizeHint() const override;
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void resizeEvent(QResizeEvent *event) override;
+  void focusInEvent(QFocusEvent *event) override;
+  void focusOutEvent(QFocusEvent *event) override;
+
+private:
+  std::array<uint8_t, columns * rows> cells{};
+  QPixmap glyphAtlas; // one cell sized glyph for every byte value, laid out 16x16
+  QSize cellSize;
+  QPoint origin; // top left corner of the character grid, the grid is centered in the widget
+
+  void buildGlyphAtlas();
+  QRect cellRect(int column, int row) const;
+};
+
+#endif // CHARACTERDISPLAY_H
@@ -15,9 +15,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "src/dialogs/ExternalDisplay.h"
+#include <QCursor>
 #include <QEvent>
 #include <QResizeEvent>
-#include <QScrollBar>
 #include "ui_ExternalDisplay.h"
 
 constexpr int defaultW = 498;
@@ -30,9 +30,6 @@ ExternalDisplay::ExternalDisplay(
   ui->setupUi(this);
   setWindowFlags(windowFlags() | Qt::WindowMaximizeButtonHint);
 
-  connect(ui->plainTextDisplay->horizontalScrollBar(), &QScrollBar::valueChanged, this, &ExternalDisplay::handleDisplayScrollHorizontal);
-  connect(ui->plainTextDisplay->verticalScrollBar(), &QScrollBar::valueChanged, this, &ExternalDisplay::handleDisplayScrollVertical);
-
   QWidget::setWindowTitle("Display");
 
   resize(defaultW, defaultH);     // Initial size
@@ -43,24 +40,48 @@ ExternalDisplay::~ExternalDisplay() {
   delete ui;
 }
 
-QPlainTextEdit *ExternalDisplay::getPlainTextEdit() {
-  return ui->plainTextDisplay;
+CharacterDisplay *ExternalDisplay::getCharacterDisplay() {
+  return ui->characterDisplay;
+}
+
+FramebufferDisplay *ExternalDisplay::getFramebufferDisplay() {
+  return ui->framebufferDisplay;
 }
 
-void ExternalDisplay::handleDisplayScrollHorizontal() {
-  ui->plainTextDisplay->horizontalScrollBar()->setValue(0);
+/**
+ * @brief Switches between the character display and the pixel framebuffer.
+ *
+ * Only the visible display is fed memory, so the other one costs nothing while hidden.
+ */
+void ExternalDisplay::setFramebufferMode(bool enabled) {
+  ui->framebufferDisplay->setVisible(enabled);
+  ui->characterDisplay->setVisible(!enabled);
 }
 
-void ExternalDisplay::handleDisplayScrollVertical() {
-  ui->plainTextDisplay->verticalScrollBar()->setValue(0);
+bool ExternalDisplay::isFramebufferMode() const {
+  return !ui->framebufferDisplay->isHidden();
 }
 
-inline int GetFontSizePerCharSize ( int w, int h) {
-  const static float WidthRatio = QFontMetricsF(QFont("Courier New", 11, QFont::Bold)).averageCharWidth() / 11.0;
-  const static float HeightRatio = QFontMetricsF(QFont("Courier New", 11, QFont::Bold)).height() / 11.0;
-  int optimalByWidth = w / WidthRatio;
-  int optimalByHeight = h / HeightRatio;
-  return qMax(11, qMin(optimalByWidth, optimalByHeight));
+void ExternalDisplay::setMemory(const std::array<uint8_t, 0x10000> &memory) {
+  if (isFramebufferMode()) {
+    ui->framebufferDisplay->setMemory(memory);
+  } else {
+    ui->characterDisplay->setMemory(memory);
+  }
+}
+
+bool ExternalDisplay::hasDisplayFocus() const {
+  return ui->characterDisplay->hasFocus() || ui->framebufferDisplay->hasFocus();
+}
+
+/**
+ * @brief Returns the cell, or the framebuffer pixel, under the mouse cursor.
+ */
+QPoint ExternalDisplay::pointerPosition() const {
+  if (isFramebufferMode()) {
+    return ui->framebufferDisplay->pixelAt(ui->framebufferDisplay->mapFromGlobal(QCursor::pos()));
+  }
+  return ui->characterDisplay->cellAt(ui->characterDisplay->mapFromGlobal(QCursor::pos()));
 }
 
 bool ExternalDisplay::eventFilter(
@@ -70,31 +91,9 @@ bool ExternalDisplay::eventFilter(
     QSize fullSize = resizeEvent->size();
     QSize availableSize = fullSize - QSize(20, 20);
 
-    QFont font = ui->plainTextDisplay->font();
-
-    int desiredWidth = 54;
-    int desiredLines = 20;
-
-    int fontWidth = availableSize.width() / desiredWidth;
-    int fontHeight = availableSize.height() / desiredLines;
-
-    int newFontSize = GetFontSizePerCharSize(fontWidth, fontHeight);
-
-    font.setPointSize(newFontSize);
-    ui->plainTextDisplay->setFont(font);
-
-    QFontMetrics fm(font);
-    int charWidth = fm.averageCharWidth();
-    int lineHeight = fm.height();
-
-    int displayWidth = charWidth * desiredWidth + ui->plainTextDisplay->document()->documentMargin() * 2;
-    int displayHeight = lineHeight * desiredLines + ui->plainTextDisplay->document()->documentMargin() * 2;
-
-    ui->plainTextDisplay->resize(displayWidth, displayHeight);
-    // -2 for widget borders
-    ui->plainTextDisplay->move((availableSize.width() - displayWidth - 2) / 2 + 10, (availableSize.height() - displayHeight - 2) / 2 + 10);
-
-
+    // the display scales its glyphs to whatever size it is given and centers the grid
+    ui->characterDisplay->setGeometry(QRect(QPoint(10, 10), availableSize));
+    ui->framebufferDisplay->setGeometry(QRect(QPoint(10, 10), availableSize));
   }
 
   return QDialog::eventFilter(obj, event);
@@ -17,8 +17,10 @@
 #ifndef EXTERNALDISPLAY_H
 #define EXTERNALDISPLAY_H
 
+#include "src/dialogs/CharacterDisplay.h"
+#include "src/dialogs/FramebufferDisplay.h"
+
 #include <QDialog>
-#include <QPlainTextEdit>
 
 namespace Ui {
   class ExternalDisplay;
@@ -29,13 +31,17 @@ class ExternalDisplay final : public QDialog {
 public:
   explicit ExternalDisplay(QWidget *parent = nullptr);
   ~ExternalDisplay() override;
-  QPlainTextEdit *getPlainTextEdit();
+  CharacterDisplay *getCharacterDisplay();
+  FramebufferDisplay *getFramebufferDisplay();
+
+  void setFramebufferMode(bool enabled);
+  bool isFramebufferMode() const;
+  void setMemory(const std::array<uint8_t, 0x10000> &memory);
+  bool hasDisplayFocus() const;
+  QPoint pointerPosition() const;
 
 private:
   Ui::ExternalDisplay *ui;
-private slots:
-  void handleDisplayScrollVertical();
-  void handleDisplayScrollHorizontal();
 
 protected:
   bool eventFilter(QObject *obj, QEvent *event) override;
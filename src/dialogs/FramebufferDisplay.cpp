@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/dialogs/FramebufferDisplay.h"
+
+#include <QPaintEvent>
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+  constexpr int borderWidth = 3;
+  constexpr int maxDimension = 256; // pointer coordinates are reported in one byte each
+
+  /**
+   * @brief The pixels of every byte value, so a byte is converted with one copy.
+   *
+   * Pixel values are mapped onto evenly spaced gray levels, black to white.
+   */
+  template <int BitsPerPixel>
+  struct ExpansionTable {
+    static constexpr int pixelsPerByte = 8 / BitsPerPixel;
+    std::array<std::array<QRgb, pixelsPerByte>, 256> pixels;
+
+    ExpansionTable() {
+      constexpr int maxValue = (1 << BitsPerPixel) - 1;
+      for (int byte = 0; byte < 256; ++byte) {
+        for (int pixel = 0; pixel < pixelsPerByte; ++pixel) {
+          int value = (byte >> (8 - BitsPerPixel * (pixel + 1))) & maxValue;
+          int level = value * 255 / maxValue;
+          pixels[byte][pixel] = qRgb(level, level, level);
+        }
+      }
+    }
+  };
+
+  template <int BitsPerPixel>
+  void expandRow(const uint8_t *source, int byteCount, QRgb *destination) {
+    static const ExpansionTable<BitsPerPixel> table;
+    for (int i = 0; i < byteCount; ++i) {
+      std::memcpy(destination + i * table.pixelsPerByte, table.pixels[source[i]].data(), sizeof(table.pixels[0]));
+    }
+  }
+} // namespace
+
+bool FramebufferDisplay::Format::isValid() const {
+  if (bitsPerPixel != 1 && bitsPerPixel != 2) {
+    return false;
+  }
+  if (width <= 0 || height <= 0 || width > maxDimension || height > maxDimension || width % (8 / bitsPerPixel) != 0) {
+    return false;
+  }
+  return address + byteCount() <= 0x10000;
+}
+
+FramebufferDisplay::FramebufferDisplay(QWidget *parent) : QWidget(parent) {
+  setFocusPolicy(Qt::StrongFocus);
+  setAttribute(Qt::WA_OpaquePaintEvent);
+  setFormat(format);
+}
+
+bool FramebufferDisplay::setFormat(const Format &newFormat) {
+  if (!newFormat.isValid()) {
+    return false;
+  }
+  format = newFormat;
+  pixels.assign(format.byteCount(), 0);
+  image = QImage(format.width, format.height, QImage::Format_RGB32);
+  image.fill(Qt::black);
+  update();
+  return true;
+}
+
+/**
+ * @brief Converts the framebuffer region of memory into the image.
+ *
+ * Only rows whose bytes differ from the previous frame are converted, each byte through a
+ * lookup table of its pixels. Nothing is repainted when the region did not change.
+ */
+void FramebufferDisplay::setMemory(const std::array<uint8_t, 0x10000> &memory) {
+  const uint8_t *region = memory.data() + format.address;
+  int rowBytes = format.bytesPerRow();
+  bool changed = false;
+  for (int y = 0; y < format.height; ++y) {
+    const uint8_t *source = region + y * rowBytes;
+    uint8_t *previous = pixels.data() + y * rowBytes;
+    if (std::memcmp(previous, source, rowBytes) == 0) {
+      continue;
+    }
+    std::memcpy(previous, source, rowBytes);
+    QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+    if (format.bitsPerPixel == 1) {
+      expandRow<1>(source, rowBytes, line);
+    } else {
+      expandRow<2>(source, rowBytes, line);
+    }
+    changed = true;
+  }
+  if (changed) {
+    update(imageRect());
+  }
+}
+
+/**
+ * @brief Returns the framebuffer pixel under a widget position, clamped to the image.
+ */
+QPoint FramebufferDisplay::pixelAt(const QPoint &position) const {
+  QRect target = imageRect();
+  int x = (position.x() - target.x()) * format.width / std::max(1, target.width());
+  int y = (position.y() - target.y()) * format.height / std::max(1, target.height());
+  return QPoint(std::clamp(x, 0, format.width - 1), std::clamp(y, 0, format.height - 1));
+}
+
+/**
+ * @brief Returns where the image is drawn, as large as fits while keeping square pixels.
+ *
+ * Whole number scales are preferred so every framebuffer pixel covers the same number of
+ * screen pixels.
+ */
+QRect FramebufferDisplay::imageRect() const {
+  QRect available = rect().adjusted(borderWidth, borderWidth, -borderWidth, -borderWidth);
+  qreal scale = std::min(static_cast<qreal>(available.width()) / format.width, static_cast<qreal>(available.height()) / format.height);
+  if (scale >= 1) {
+    scale = std::floor(scale);
+  }
+  QSize size(std::max(1, static_cast<int>(format.width * scale)), std::max(1, static_cast<int>(format.height * scale)));
+  return QRect(QPoint((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+}
+
+void FramebufferDisplay::paintEvent(QPaintEvent *event) {
+  QPainter painter(this);
+  painter.fillRect(event->rect(), Qt::black);
+  painter.drawImage(imageRect(), image);
+
+  if (hasFocus()) {
+    painter.setPen(QPen(Qt::blue, borderWidth));
+    painter.drawRect(rect().adjusted(1, 1, -2, -2));
+  }
+}
+
+void FramebufferDisplay::focusInEvent(QFocusEvent *event) {
+  QWidget::focusInEvent(event);
+  update();
+}
+
+void FramebufferDisplay::focusOutEvent(QFocusEvent *event) {
+  QWidget::focusOutEvent(event);
+  update();
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FRAMEBUFFERDISPLAY_H
+#define FRAMEBUFFERDISPLAY_H
+
+#include <QImage>
+#include <QWidget>
+
+#include <array>
+#include <stdint.h>
+#include <vector>
+
+class FramebufferDisplay final : public QWidget {
+  Q_OBJECT
+
+public:
+  struct Format {
+    uint16_t address = 0xF700;
+    int width = 128;
+    int height = 64;
+    int bitsPerPixel = 1; // 1 or 2, the most significant bits are the leftmost pixel
+
+    int bytesPerRow() const { return width * bitsPerPixel / 8; }
+    int byteCount() const { return bytesPerRow() * height; }
+    bool isValid() const;
+  };
+
+  explicit FramebufferDisplay(QWidget *parent = nullptr);
+
+  bool setFormat(const Format &newFormat);
+  const Format &getFormat() const { return format; }
+  void setMemory(const std::array<uint8_t, 0x10000> &memory);
+  QPoint pixelAt(const QPoint &position) const;
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void focusInEvent(QFocusEvent *event) override;
+  void focusOutEvent(QFocusEvent *event) override;
+
+private:
+  Format format;
+  std::vector<uint8_t> pixels; // copy of the framebuffer region as of the last conversion
+  QImage image;
+
+  QRect imageRect() const;
+};
+
+#endif // FRAMEBUFFERDISPLAY_H
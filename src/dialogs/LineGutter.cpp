@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/dialogs/LineGutter.h"
+
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextBlock>
+
+namespace {
+  const QColor backgroundColor(255, 253, 201);
+  constexpr int textMargin = 4;
+  constexpr int simpleColumns = 10;   // "00000:0000"
+  constexpr int advancedColumns = 22; // "00000:0000:00:00:00  12"
+} // namespace
+
+LineGutter::LineGutter(QWidget *parent) : QWidget(parent) {
+  setAttribute(Qt::WA_OpaquePaintEvent);
+  updateWidth();
+}
+
+/**
+ * @brief Attaches the gutter to the code editor it annotates.
+ *
+ * The gutter follows the editor's scrolling and edits through its update requests, there is
+ * no separate scroll position to keep in sync.
+ */
+void LineGutter::setEditor(QPlainTextEdit *codeEditor) {
+  editor = codeEditor;
+  connect(editor, &QPlainTextEdit::updateRequest, this, [this](const QRect &rect, int dy) {
+    if (dy != 0) {
+      update();
+    } else {
+      update(0, rect.y() + viewportOffset(), width(), rect.height());
+    }
+  });
+  connect(editor, &QPlainTextEdit::blockCountChanged, this, [this]() { update(); });
+  connect(editor->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() { update(); });
+  update();
+}
+
+void LineGutter::setAssemblyMap(const Core::AssemblyMap *map, Core::ProcessorVersion version) {
+  assemblyMap = map;
+  processorVersion = version;
+  update();
+}
+
+void LineGutter::setAdvancedInfo(bool enabled) {
+  advancedInfo = enabled;
+  updateWidth();
+  update();
+}
+
+void LineGutter::updateWidth() {
+  int columns = advancedInfo ? advancedColumns : simpleColumns;
+  setFixedWidth(fontMetrics().horizontalAdvance(QString(columns, '0')) + textMargin * 2 + 1);
+}
+
+void LineGutter::setLineMarkers(const QHash<int, QBrush> &markers) {
+  lineMarkers = markers;
+  update();
+}
+
+/**
+ * @brief Returns how far below the top of the gutter the editor's viewport starts.
+ */
+int LineGutter::viewportOffset() const {
+  return editor->viewport()->mapTo(window(), QPoint(0, 0)).y() - mapTo(window(), QPoint(0, 0)).y();
+}
+
+/**
+ * @brief Formats the annotation of one source line from the assembly map.
+ */
+QString LineGutter::lineText(int line) const {
+  QString text = QString("%1:").arg(line, 5, 10, QChar('0'));
+  if (assemblyMap == nullptr) {
+    return text + "----";
+  }
+  const Core::AssemblyMap::MappedInstr &instr = assemblyMap->getObjectByLine(line);
+  if (instr.address == -1) {
+    return text + "----";
+  }
+  text += QString("%1").arg(instr.address, 4, 16, QChar('0'));
+  if (!advancedInfo) {
+    return text;
+  }
+  int length = Core::getInstructionLength(processorVersion, instr.byte1);
+  if (length > 0)
+    text += ":" + QString("%1").arg(instr.byte1, 2, 16, QChar('0'));
+  if (length > 1)
+    text += ":" + QString("%1").arg(instr.byte2, 2, 16, QChar('0'));
+  if (length > 2)
+    text += ":" + QString("%1").arg(instr.byte3, 2, 16, QChar('0'));
+  if (length > 0)
+    text = text.leftJustified(19, ' ') + QString("%1").arg(Core::getInstructionCycleCount(processorVersion, instr.byte1), 3);
+  return text;
+}
+
+/**
+ * @brief Paints the rows of the source lines currently visible in the editor.
+ *
+ * Only visible lines are formatted, each with one assembly map lookup, so the cost does not
+ * depend on the length of the file.
+ */
+void LineGutter::paintEvent(QPaintEvent *event) {
+  QPainter painter(this);
+  painter.fillRect(event->rect(), backgroundColor);
+  painter.setPen(Qt::black);
+  painter.drawLine(0, 0, 0, height() - 1);
+  painter.drawLine(0, 0, width() - 1, 0);
+  if (editor == nullptr) {
+    return;
+  }
+
+  int offset = viewportOffset();
+  int viewportBottom = offset + editor->viewport()->height();
+  painter.drawLine(0, viewportBottom, width() - 1, viewportBottom);
+  painter.setClipRect(QRect(1, offset, width() - 1, editor->viewport()->height()) & event->rect());
+
+  QTextBlock block = editor->cursorForPosition(QPoint(0, 0)).block();
+  while (block.isValid()) {
+    QRect cursorRect = editor->cursorRect(QTextCursor(block));
+    QRect row(1, cursorRect.top() + offset, width() - 1, cursorRect.height());
+    if (row.top() > viewportBottom || row.top() > event->rect().bottom()) {
+      break;
+    }
+    if (row.bottom() >= event->rect().top()) {
+      auto marker = lineMarkers.constFind(block.blockNumber());
+      if (marker != lineMarkers.constEnd()) {
+        painter.fillRect(row, marker.value());
+      }
+      painter.drawText(row.adjusted(textMargin, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter, lineText(block.blockNumber()));
+    }
+    block = block.next();
+  }
+}
+
+void LineGutter::changeEvent(QEvent *event) {
+  QWidget::changeEvent(event);
+  if (event->type() == QEvent::FontChange) {
+    updateWidth();
+  }
+}
+
+void LineGutter::mousePressEvent(QMouseEvent *event) {
+  if (editor == nullptr) {
+    return;
+  }
+  int y = event->position().toPoint().y() - viewportOffset();
+  if (y < 0 || y >= editor->viewport()->height()) {
+    return;
+  }
+  QTextBlock block = editor->cursorForPosition(QPoint(0, y)).block();
+  QRect cursorRect = editor->cursorRect(QTextCursor(block));
+  if (y <= cursorRect.bottom()) {
+    emit lineClicked(block.blockNumber(), event->button());
+  }
+}
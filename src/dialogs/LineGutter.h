@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINEGUTTER_H
+#define LINEGUTTER_H
+
+#include "src/core/Core.h"
+
+#include <QBrush>
+#include <QHash>
+#include <QPlainTextEdit>
+#include <QWidget>
+
+class LineGutter final : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit LineGutter(QWidget *parent = nullptr);
+
+  void setEditor(QPlainTextEdit *codeEditor);
+  void setAssemblyMap(const Core::AssemblyMap *map, Core::ProcessorVersion version);
+  void setAdvancedInfo(bool enabled);
+  void setLineMarkers(const QHash<int, QBrush> &markers);
+
+signals:
+  void lineClicked(int line, Qt::MouseButton button);
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void changeEvent(QEvent *event) override;
+  void mousePressEvent(QMouseEvent *event) override;
+
+private:
+  QPlainTextEdit *editor = nullptr;
+  const Core::AssemblyMap *assemblyMap = nullptr;
+  Core::ProcessorVersion processorVersion = Core::ProcessorVersion::M6800;
+  bool advancedInfo = false;
+  QHash<int, QBrush> lineMarkers;
+
+  void updateWidth();
+  int viewportOffset() const;
+  QString lineText(int line) const;
+};
+
+#endif // LINEGUTTER_H
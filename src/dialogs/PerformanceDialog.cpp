@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/dialogs/PerformanceDialog.h"
+
+#include <QFormLayout>
+#include <QLabel>
+
+#include <algorithm>
+
+PerformanceDialog::PerformanceDialog(QWidget *parent) : QDialog(parent) {
+  setWindowTitle(tr("Performance"));
+  auto *layout = new QFormLayout(this);
+  auto addRow = [layout](const QString &name) {
+    auto *label = new QLabel("-");
+    label->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    label->setMinimumWidth(label->fontMetrics().horizontalAdvance("000000000.0"));
+    layout->addRow(name, label);
+    return label;
+  };
+  labelInstructions = addRow(tr("Instructions per second:"));
+  labelCycles = addRow(tr("Cycles per second:"));
+  labelSpeedRatio = addRow(tr("Ratio to requested speed:"));
+  labelThreadLoad = addRow(tr("Execution thread load:"));
+  labelFrameTime = addRow(tr("UI frame time (avg / max):"));
+  labelDroppedFrames = addRow(tr("Dropped frames:"));
+  labelQueueDepth = addRow(tr("Action queue depth (max):"));
+  labelCopyTime = addRow(tr("Snapshot copy time (max):"));
+}
+
+/**
+ * @brief Starts measuring a new run, the figures shown are kept until the first window completes.
+ */
+void PerformanceDialog::reset(double requestedOperationsPerSecond) {
+  requestedSpeed = requestedOperationsPerSecond;
+  windowStarted = false;
+}
+
+void PerformanceDialog::setRequestedSpeed(double operationsPerSecond) {
+  requestedSpeed = operationsPerSecond;
+}
+
+/**
+ * @brief Accounts one drawn frame and refreshes the figures about twice a second.
+ *
+ * Rates are computed from the difference of two processor samples, so they do not depend on how
+ * often the UI manages to draw.
+ *
+ * @param snapshot The snapshot drawn in this frame.
+ * @param frameNanoseconds Time taken to draw the frame.
+ * @param droppedFrames Frames lost since the previous frame, to late refreshes or replaced snapshots.
+ */
+void PerformanceDialog::addFrame(const Core::ProcessorSnapshot &snapshot, qint64 frameNanoseconds, int droppedFrames) {
+  if (!windowStarted) {
+    startWindow(snapshot.performance);
+    return;
+  }
+  frameTimeTotal += frameNanoseconds;
+  frameTimeMax = std::max(frameTimeMax, frameNanoseconds);
+  frameCount++;
+  droppedFrameCount += droppedFrames;
+  maxQueueDepth = std::max(maxQueueDepth, snapshot.performance.actionQueueDepth);
+  copyTimeMax = std::max(copyTimeMax, static_cast<qint64>(snapshot.performance.copyNanoseconds));
+
+  if (snapshot.performance.capturedAt - windowStart.capturedAt >= updateIntervalNanoseconds) {
+    showWindow(snapshot);
+    startWindow(snapshot.performance);
+  }
+}
+
+void PerformanceDialog::startWindow(const Core::PerformanceSample &sample) {
+  windowStarted = true;
+  windowStart = sample;
+  frameTimeTotal = 0;
+  frameTimeMax = 0;
+  frameCount = 0;
+  droppedFrameCount = 0;
+  maxQueueDepth = 0;
+  copyTimeMax = 0;
+}
+
+void PerformanceDialog::showWindow(const Core::ProcessorSnapshot &snapshot) {
+  const Core::PerformanceSample &end = snapshot.performance;
+  double seconds = (end.capturedAt - windowStart.capturedAt) / 1e9;
+  double instructionsPerSecond = (end.instructions - windowStart.instructions) / seconds;
+  double cyclesPerSecond = (end.cycles - windowStart.cycles) / seconds;
+  double operationsPerSecond = snapshot.useCycles ? cyclesPerSecond : instructionsPerSecond;
+
+  labelInstructions->setText(QString::number(instructionsPerSecond, 'f', 0));
+  labelCycles->setText(QString::number(cyclesPerSecond, 'f', 0));
+  labelSpeedRatio->setText(QString::number(operationsPerSecond / requestedSpeed * 100, 'f', 1) + " %");
+  labelThreadLoad->setText(QString::number((end.busyNanoseconds - windowStart.busyNanoseconds) / (seconds * 1e9) * 100, 'f', 1) + " %");
+  labelFrameTime->setText(QString("%1 / %2 ms").arg(frameTimeTotal / 1e6 / std::max(1, frameCount), 0, 'f', 2).arg(frameTimeMax / 1e6, 0, 'f', 2));
+  labelDroppedFrames->setText(QString("%1 of %2").arg(droppedFrameCount).arg(frameCount + droppedFrameCount));
+  labelQueueDepth->setText(QString("%1 (%2)").arg(end.actionQueueDepth).arg(maxQueueDepth));
+  labelCopyTime->setText(QString("%1 (%2) us").arg(end.copyNanoseconds / 1e3, 0, 'f', 1).arg(copyTimeMax / 1e3, 0, 'f', 1));
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PERFORMANCEDIALOG_H
+#define PERFORMANCEDIALOG_H
+
+#include "src/core/Core.h"
+
+#include <QDialog>
+
+class QLabel;
+
+class PerformanceDialog final : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit PerformanceDialog(QWidget *parent = nullptr);
+
+  void reset(double requestedOperationsPerSecond);
+  void setRequestedSpeed(double operationsPerSecond);
+  void addFrame(const Core::ProcessorSnapshot &snapshot, qint64 frameNanoseconds, int droppedFrames);
+
+private:
+  static constexpr qint64 updateIntervalNanoseconds = 500000000;
+
+  double requestedSpeed = 1;
+  bool windowStarted = false;
+  Core::PerformanceSample windowStart{};
+  qint64 frameTimeTotal = 0;
+  qint64 frameTimeMax = 0;
+  int frameCount = 0;
+  int droppedFrameCount = 0;
+  int maxQueueDepth = 0;
+  qint64 copyTimeMax = 0;
+
+  QLabel *labelInstructions;
+  QLabel *labelCycles;
+  QLabel *labelSpeedRatio;
+  QLabel *labelThreadLoad;
+  QLabel *labelFrameTime;
+  QLabel *labelDroppedFrames;
+  QLabel *labelQueueDepth;
+  QLabel *labelCopyTime;
+
+  void startWindow(const Core::PerformanceSample &sample);
+  void showWindow(const Core::ProcessorSnapshot &snapshot);
+};
+
+#endif // PERFORMANCEDIALOG_H
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/dialogs/SerialConsole.h"
+#include "src/processor/Processor.h"
+#include "src/utils/SerialHost.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QTextCursor>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+  constexpr int baudRates[] = {300, 1200, 2400, 4800, 9600, 19200, 38400, 57600};
+  constexpr int maxOutputLines = 2000;
+} // namespace
+
+SerialConsole::SerialConsole(Processor *emulator, QWidget *parent)
+    : QDialog(parent), processor(emulator), acia(emulator->serial), host(new SerialHost(emulator->serial, this)) {
+  setWindowTitle(tr("Serial Console"));
+  resize(640, 400);
+
+  comboAddress = new QComboBox(this);
+  for (int address = Core::deviceRegistersStart; address + Acia6850::registerCount <= Core::deviceRegistersEnd; address += Acia6850::registerCount) {
+    if (processor->isDeviceAddressFree(address, Acia6850::registerCount, acia)) {
+      comboAddress->addItem(QString("$%1").arg(address, 4, 16, QChar('0')).toUpper(), address);
+    }
+  }
+  comboAddress->setCurrentIndex(comboAddress->findData(acia.address()));
+  connect(comboAddress, &QComboBox::currentIndexChanged, this, [this]() {
+    processor->addAction(Core::Action{Core::ActionType::SETSERIALADDRESS, comboAddress->currentData().toUInt()});
+  });
+
+  comboBaud = new QComboBox(this);
+  for (int rate : baudRates) {
+    comboBaud->addItem(QString::number(rate), rate);
+  }
+  comboBaud->setCurrentIndex(comboBaud->findData(Acia6850::defaultBaudRate));
+  connect(comboBaud, &QComboBox::currentIndexChanged, this, [this]() {
+    processor->addAction(Core::Action{Core::ActionType::SETSERIALBAUD, comboBaud->currentData().toUInt()});
+  });
+
+  checkPseudoTerminal = new QCheckBox(tr("Pseudo-terminal"), this);
+#ifdef _WIN32
+  checkPseudoTerminal->setVisible(false);
+#endif
+  connect(checkPseudoTerminal, &QCheckBox::toggled, this, &SerialConsole::setPseudoTerminal);
+
+  auto *settings = new QHBoxLayout();
+  settings->addWidget(new QLabel(tr("Address:"), this));
+  settings->addWidget(comboAddress);
+  settings->addWidget(new QLabel(tr("Baud:"), this));
+  settings->addWidget(comboBaud);
+  settings->addWidget(checkPseudoTerminal);
+  settings->addStretch();
+
+  output = new QPlainTextEdit(this);
+  output->setReadOnly(true);
+  output->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  output->setMaximumBlockCount(maxOutputLines);
+  output->setLineWrapMode(QPlainTextEdit::WidgetWidth);
+  output->installEventFilter(this);
+
+  labelLine = new QLabel(tr("Type into the pane to send to the ACIA."), this);
+
+  auto *layout = new QVBoxLayout(this);
+  layout->addLayout(settings);
+  layout->addWidget(output);
+  layout->addWidget(labelLine);
+
+  refreshTimer = new QTimer(this);
+  refreshTimer->setInterval(refreshMilliseconds);
+  connect(refreshTimer, &QTimer::timeout, this, &SerialConsole::drainOutput);
+}
+
+SerialConsole::~SerialConsole() {
+  host->close();
+}
+
+/**
+ * @brief Appends the characters transmitted since the last refresh.
+ *
+ * Carriage returns are dropped and line feeds start a new line, backspace removes the last
+ * character. Other control characters are not shown.
+ */
+void SerialConsole::drainOutput() {
+  QString text;
+  int erase = 0;
+  uint8_t byte;
+  while (acia.transmitted.pop(byte)) {
+    if (byte == '\n' || (byte >= 0x20 && byte < 0x7F)) {
+      text += QChar(byte);
+    } else if (byte == 8) {
+      if (!text.isEmpty()) {
+        text.chop(1);
+      } else {
+        erase++;
+      }
+    }
+  }
+  if (text.isEmpty() && erase == 0) {
+    return;
+  }
+  QTextCursor cursor(output->document());
+  cursor.movePosition(QTextCursor::End);
+  for (; erase > 0 && !cursor.atBlockStart(); --erase) {
+    cursor.deletePreviousChar();
+  }
+  cursor.insertText(text);
+  output->setTextCursor(cursor);
+  output->ensureCursorVisible();
+}
+
+/**
+ * @brief Polls the ACIA only while the pane is the line, shown and not replaced by a pseudo-terminal.
+ */
+void SerialConsole::updatePolling() {
+  if (isVisible() && !host->isRunning()) {
+    refreshTimer->start();
+  } else {
+    refreshTimer->stop();
+  }
+}
+
+void SerialConsole::showEvent(QShowEvent *event) {
+  QDialog::showEvent(event);
+  updatePolling();
+}
+
+void SerialConsole::hideEvent(QHideEvent *event) {
+  QDialog::hideEvent(event);
+  updatePolling();
+}
+
+void SerialConsole::setPseudoTerminal(bool enabled) {
+  if (!enabled) {
+    host->close();
+    labelLine->setText(tr("Type into the pane to send to the ACIA."));
+  } else if (host->openPseudoTerminal()) {
+    labelLine->setText(tr("Connected to %1").arg(host->devicePath()));
+  } else {
+    labelLine->setText(host->errorString());
+    checkPseudoTerminal->setChecked(false);
+  }
+  updatePolling();
+}
+
+/**
+ * @brief Sends the keys typed into the pane, Enter as a carriage return like a terminal.
+ */
+bool SerialConsole::eventFilter(QObject *obj, QEvent *event) {
+  if (obj == output && event->type() == QEvent::KeyPress && !host->isRunning()) {
+    QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+    QByteArray bytes;
+    switch (keyEvent->key()) {
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+      bytes = "\r";
+      break;
+    case Qt::Key_Backspace:
+      bytes = "\b";
+      break;
+    case Qt::Key_Escape:
+      bytes = "\x1b";
+      break;
+    default:
+      bytes = keyEvent->text().toLatin1();
+      break;
+    }
+    if (bytes.isEmpty()) {
+      return false;
+    }
+    for (char byte : bytes) {
+      acia.received.push(static_cast<uint8_t>(byte));
+    }
+    return true;
+  }
+  return QDialog::eventFilter(obj, event);
+}
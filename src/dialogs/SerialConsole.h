@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SERIALCONSOLE_H
+#define SERIALCONSOLE_H
+
+#include <QDialog>
+
+class Acia6850;
+class Processor;
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QPlainTextEdit;
+class QTimer;
+class SerialHost;
+
+/**
+ * Terminal pane for the ACIA's serial line.
+ *
+ * Keys typed into the pane are sent to the ACIA and characters it transmits are shown, both
+ * through the ACIA's ring buffers. The line can instead be connected to a pseudo-terminal, then
+ * the pane only shows the path for a terminal program to open. While the pane is closed its line
+ * is not read, the ACIA's transmitter waits as for a peer that dropped clear to send.
+ */
+class SerialConsole final : public QDialog {
+  Q_OBJECT
+
+public:
+  SerialConsole(Processor *emulator, QWidget *parent = nullptr);
+  ~SerialConsole() override;
+
+protected:
+  bool eventFilter(QObject *obj, QEvent *event) override;
+  void showEvent(QShowEvent *event) override;
+  void hideEvent(QHideEvent *event) override;
+
+private:
+  static constexpr int refreshMilliseconds = 20;
+
+  Processor *processor;
+  Acia6850 &acia;
+  SerialHost *host;
+  QPlainTextEdit *output;
+  QComboBox *comboAddress;
+  QComboBox *comboBaud;
+  QCheckBox *checkPseudoTerminal;
+  QLabel *labelLine;
+  QTimer *refreshTimer;
+
+  void drainOutput();
+  void updatePolling();
+  void setPseudoTerminal(bool enabled);
+};
+
+#endif // SERIALCONSOLE_H
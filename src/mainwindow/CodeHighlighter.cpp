@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/mainwindow/CodeHighlighter.h"
+#include "src/core/Core.h"
+
+#include <QTextBlock>
+
+#include <algorithm>
+
+namespace {
+  constexpr int maxEagerBlocks = 256; // larger edits are highlighted as they scroll into view
+
+  struct Keywords {
+    QSet<QString> mnemonics;
+    QSet<QString> directives;
+
+    Keywords() {
+      for (const Core::MnemonicInfo &info : Core::mnemonics) {
+        (info.mnemonic.startsWith('.') ? directives : mnemonics).insert(info.mnemonic);
+      }
+      for (auto it = Core::alliasMap.cbegin(); it != Core::alliasMap.cend(); ++it) {
+        (it.value().mnemonic.startsWith('.') ? directives : mnemonics).insert(it.key());
+      }
+    }
+  };
+
+  const Keywords &keywords() {
+    static const Keywords table;
+    return table;
+  }
+
+  bool isSymbolCharacter(QChar c) {
+    return c.isLetterOrNumber() || c == '_';
+  }
+} // namespace
+
+CodeHighlighter::CodeHighlighter(QPlainTextEdit *codeEditor) : QSyntaxHighlighter(static_cast<QObject *>(codeEditor)), editor(codeEditor) {
+  mnemonicFormat.setForeground(Qt::darkBlue);
+  mnemonicFormat.setFontWeight(QFont::Bold);
+  directiveFormat.setForeground(Qt::darkMagenta);
+  directiveFormat.setFontWeight(QFont::Bold);
+  labelFormat.setForeground(Qt::darkRed);
+  symbolFormat.setForeground(Qt::darkCyan);
+  numberFormat.setForeground(Qt::darkGreen);
+  stringFormat.setForeground(QColor(160, 90, 0));
+  commentFormat.setForeground(Qt::gray);
+  commentFormat.setFontItalic(true);
+
+  // connected before the document is set so large edits are known before they are highlighted
+  connect(editor->document(), &QTextDocument::contentsChange, this, &CodeHighlighter::handleContentsChange);
+  connect(editor, &QPlainTextEdit::updateRequest, this, &CodeHighlighter::refreshVisibleBlocks);
+  setDocument(editor->document());
+}
+
+/**
+ * @brief Replaces the symbols colored in operands with the labels of an assembly result.
+ *
+ * Blocks are not rehighlighted here, every block remembers the symbol table it was highlighted
+ * with and only the visible ones are brought up to date, the rest follow as they are scrolled to.
+ */
+void CodeHighlighter::setSymbols(const std::map<QString, int> &assembledSymbols) {
+  symbols.clear();
+  for (const auto &[name, value] : assembledSymbols) {
+    symbols.insert(name);
+  }
+  symbolGeneration++;
+  refreshVisibleBlocks();
+}
+
+/**
+ * @brief Defers highlighting of edits spanning many lines, such as opening a file.
+ *
+ * The block state is never used, so an edit only rehighlights the blocks it touched.
+ */
+void CodeHighlighter::handleContentsChange(int position, int charsRemoved, int charsAdded) {
+  Q_UNUSED(charsRemoved);
+  QTextBlock first = document()->findBlock(position);
+  QTextBlock last = document()->findBlock(position + charsAdded);
+  if (last.isValid() && last.blockNumber() - first.blockNumber() > maxEagerBlocks) {
+    deferredUntil = position + charsAdded;
+  }
+}
+
+/**
+ * @brief Highlights the visible blocks which are deferred or use an older symbol table.
+ */
+void CodeHighlighter::refreshVisibleBlocks() {
+  if (refreshing) {
+    return;
+  }
+  refreshing = true;
+  deferredUntil = -1;
+  int viewportHeight = editor->viewport()->height();
+  QTextBlock block = editor->cursorForPosition(QPoint(0, 0)).block();
+  while (block.isValid() && editor->cursorRect(QTextCursor(block)).top() < viewportHeight) {
+    auto *data = static_cast<BlockData *>(block.userData());
+    if (data == nullptr || data->symbolGeneration != symbolGeneration) {
+      rehighlightBlock(block);
+    }
+    block = block.next();
+  }
+  refreshing = false;
+}
+
+void CodeHighlighter::markBlock(int generation) {
+  auto *data = static_cast<BlockData *>(currentBlockUserData());
+  if (data == nullptr) {
+    data = new BlockData;
+    setCurrentBlockUserData(data);
+  }
+  data->symbolGeneration = generation;
+}
+
+/**
+ * @brief Colors one line following the layout the assembler expects.
+ *
+ * A label starts in the first column, the instruction follows after whitespace and the rest of
+ * the line up to a ';' comment is the operand.
+ */
+void CodeHighlighter::highlightBlock(const QString &text) {
+  if (currentBlock().position() < deferredUntil) {
+    markBlock(-1);
+    return;
+  }
+  markBlock(symbolGeneration);
+
+  int end = text.indexOf(';');
+  if (end == -1) {
+    end = text.size();
+  } else {
+    setFormat(end, text.size() - end, commentFormat);
+  }
+
+  int position = 0;
+  if (end > 0 && text[0].isLetter()) {
+    while (position < end && isSymbolCharacter(text[position])) {
+      position++;
+    }
+    setFormat(0, position, labelFormat);
+  }
+  while (position < end && text[position].isSpace()) {
+    position++;
+  }
+
+  int start = position;
+  while (position < end && !text[position].isSpace()) {
+    position++;
+  }
+  if (position > start) {
+    QString instruction = text.sliced(start, position - start).toUpper();
+    if (keywords().mnemonics.contains(instruction)) {
+      setFormat(start, position - start, mnemonicFormat);
+    } else if (keywords().directives.contains(instruction)) {
+      setFormat(start, position - start, directiveFormat);
+    }
+  }
+
+  highlightOperand(text, position, end);
+}
+
+void CodeHighlighter::highlightOperand(const QString &text, int start, int end) {
+  int position = start;
+  while (position < end) {
+    QChar c = text[position];
+    int tokenStart = position;
+    if (c == '\'' || c == '"') {
+      position++;
+      while (position < end && text[position] != c) {
+        position++;
+      }
+      position = std::min(position + 1, end);
+      setFormat(tokenStart, position - tokenStart, stringFormat);
+    } else if (c.isDigit() || ((c == '$' || c == '%') && position + 1 < end && text[position + 1].isLetterOrNumber())) {
+      position++;
+      while (position < end && text[position].isLetterOrNumber()) {
+        position++;
+      }
+      setFormat(tokenStart, position - tokenStart, numberFormat);
+    } else if (c.isLetter()) {
+      while (position < end && isSymbolCharacter(text[position])) {
+        position++;
+      }
+      if (symbols.contains(text.sliced(tokenStart, position - tokenStart).toUpper())) {
+        setFormat(tokenStart, position - tokenStart, symbolFormat);
+      }
+    } else {
+      position++;
+    }
+  }
+}
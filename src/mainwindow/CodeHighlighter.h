@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CODEHIGHLIGHTER_H
+#define CODEHIGHLIGHTER_H
+
+#include <QPlainTextEdit>
+#include <QSet>
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+
+#include <map>
+
+class CodeHighlighter final : public QSyntaxHighlighter {
+  Q_OBJECT
+
+public:
+  explicit CodeHighlighter(QPlainTextEdit *codeEditor);
+
+  void setSymbols(const std::map<QString, int> &assembledSymbols);
+
+protected:
+  void highlightBlock(const QString &text) override;
+
+private:
+  // symbol table generation a block was highlighted with, -1 if highlighting was deferred
+  struct BlockData final : QTextBlockUserData {
+    int symbolGeneration = -1;
+  };
+
+  QPlainTextEdit *editor;
+  QSet<QString> symbols; // label names of the latest successful assembly, upper case
+  int symbolGeneration = 0;
+  int deferredUntil = -1; // blocks before this position are left for refreshVisibleBlocks
+  bool refreshing = false;
+
+  QTextCharFormat mnemonicFormat;
+  QTextCharFormat directiveFormat;
+  QTextCharFormat labelFormat;
+  QTextCharFormat symbolFormat;
+  QTextCharFormat numberFormat;
+  QTextCharFormat stringFormat;
+  QTextCharFormat commentFormat;
+
+  void handleContentsChange(int position, int charsRemoved, int charsAdded);
+  void refreshVisibleBlocks();
+  void highlightOperand(const QString &text, int start, int end);
+  void markBlock(int generation);
+};
+
+#endif // CODEHIGHLIGHTER_H
@@ -15,18 +15,24 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "qscrollbar.h"
+#include "src/dialogs/LineGutter.h"
 #include "src/mainwindow/MainWindow.h"
+#include "src/mainwindow/MemoryTableModel.h"
 #include "src/processor/Processor.h"
 #include "ui_MainWindow.h"
 #include <QTextBlock>
 
+#include <set>
+
 using Core::Action;
 using Core::ActionType;
 using Core::ColorType;
 using Core::MemoryDisplayMode;
 
 int runtimeMarkerAddress = 0;
-QVector<int> markedLineList;
+int runtimeMarkerBank = 0;
+int runtimeMarkerLine = -1; // line the current instruction marker was last drawn on
+std::set<int> markedLines;
 
 const QBrush brushMarked{Qt::GlobalColor::green};
 const QBrush brushRuntime(Qt::GlobalColor::yellow);
@@ -55,7 +61,7 @@ const QBrush &getBrushForType(ColorType colorType) {
 
 void MainWindow::colorMemory(int address, ColorType colorType) {
   if (memoryDisplayMode == MemoryDisplayMode::FULL) {
-    ui->tableWidgetMemory->item(address / 16, address % 16)->setBackground(getBrushForType(colorType));
+    memoryModel->setCellBackground(address, getBrushForType(colorType));
   } else if (memoryDisplayMode == MemoryDisplayMode::SIMPLE) {
     int row = address - currentSMScroll;
     if (row >= 0 && row < 20) {
@@ -86,31 +92,38 @@ QTextEdit::ExtraSelection getLineMarker(QPlainTextEdit *textEdit, int line, Colo
 
 void MainWindow::drawTextMarkers() {
   errorDisplayed = false;
-  QList<QTextEdit::ExtraSelection> lineMarkers;
+  QHash<int, QBrush> lineMarkers;
   QList<QTextEdit::ExtraSelection> codeMarkers;
 
-  int runtimeLine = assemblyMap.getObjectByAddress(runtimeMarkerAddress).lineNumber;
+  int runtimeLine = assemblyMap.getObjectByAddress(runtimeMarkerAddress, runtimeMarkerBank).lineNumber;
+  runtimeMarkerLine = runtimeLine;
 
-  for (int line : markedLineList) {
+  for (int line : markedLines) {
     ColorType type = line == runtimeLine ? ColorType::MARKED_CURRENTINSTRUCTION : ColorType::MARKED;
-    lineMarkers.append(getLineMarker(ui->plainTextLines, line, type));
+    lineMarkers.insert(line, getBrushForType(type));
     codeMarkers.append(getLineMarker(ui->plainTextCode, line, type));
   }
 
-  if (runtimeLine != -1 && !markedLineList.contains(runtimeLine)) {
-    lineMarkers.append(getLineMarker(ui->plainTextLines, runtimeLine, ColorType::CURRENTINSTRUCTION));
+  if (runtimeLine != -1 && markedLines.count(runtimeLine) == 0) {
+    lineMarkers.insert(runtimeLine, getBrushForType(ColorType::CURRENTINSTRUCTION));
     codeMarkers.append(getLineMarker(ui->plainTextCode, runtimeLine, ColorType::CURRENTINSTRUCTION));
   }
 
-  ui->plainTextLines->setExtraSelections(lineMarkers);
+  ui->lineGutter->setLineMarkers(lineMarkers);
   ui->plainTextCode->setExtraSelections(codeMarkers);
 }
 
+/**
+ * @brief Colors the bookmarked addresses and the current instruction in the memory view.
+ *
+ * Only the bookmarks themselves are visited, each address is looked up in the bookmark set,
+ * so the cost does not depend on the size of the memory view.
+ */
 void MainWindow::drawMemoryMarkers() {
   if (memoryDisplayMode == MemoryDisplayMode::SIMPLE) {
     for (int row = 0; row < ui->tableWidgetSM->rowCount(); ++row) {
       int adr = row + currentSMScroll;
-      if (markedAddressList.contains(adr)) {
+      if (adr <= 0xFFFF && markedAddresses.test(adr)) {
         ui->tableWidgetSM->item(row, 0)->setBackground(getBrushForType(ColorType::MARKED));
         ui->tableWidgetSM->item(row, 1)->setBackground(getBrushForType(ColorType::MARKED));
         ui->tableWidgetSM->item(row, 2)->setBackground(getBrushForType(ColorType::MARKED));
@@ -121,20 +134,16 @@ void MainWindow::drawMemoryMarkers() {
       }
     }
   } else if (memoryDisplayMode == MemoryDisplayMode::FULL) {
-    for (int row = 0; row < ui->tableWidgetMemory->rowCount(); ++row) {
-      for (int col = 0; col < ui->tableWidgetMemory->columnCount(); ++col) {
-        uint16_t address = static_cast<uint16_t>(row * 16 + col);
-
-        if (markedAddressList.contains(address)) {
-          colorMemory(address, ColorType::MARKED);
-        } else {
-          colorMemory(address, ColorType::NONE);
-        }
+    memoryModel->clearCellBackgrounds();
+    for (int line : markedLines) {
+      int address = assemblyMap.getObjectByLine(line).address;
+      if (address >= 0 && markedAddresses.test(address)) {
+        colorMemory(address, ColorType::MARKED);
       }
     }
   }
 
-  if (markedAddressList.contains(runtimeMarkerAddress)) {
+  if (markedAddresses.test(runtimeMarkerAddress)) {
     colorMemory(runtimeMarkerAddress, ColorType::MARKED_CURRENTINSTRUCTION);
   } else {
     colorMemory(runtimeMarkerAddress, ColorType::CURRENTINSTRUCTION);
@@ -145,22 +154,21 @@ void MainWindow::toggleCodeMarker(int line) {
   if (line == -1)
     return;
   int address = assemblyMap.getObjectByLine(line).address;
-  if (markedLineList.contains(line)) {
-    markedLineList.removeOne(line);
+  if (markedLines.erase(line) > 0) {
     if (address >= 0) {
-      markedAddressList.removeOne(address);
-      processor->queueBookmarkData(markedAddressList);
+      markedAddresses.reset(address);
+      processor->queueBookmarkData(markedAddresses);
       processor->addAction(Action{ActionType::UPDATEBOOKMARKS, 0});
 
       ColorType type = (address == runtimeMarkerAddress) ? ColorType::CURRENTINSTRUCTION : ColorType::NONE;
       colorMemory(address, type);
     }
   } else {
-    markedLineList.append(line);
+    markedLines.insert(line);
     if (address >= 0) {
-      if (markedAddressList.count(address) == 0) {
-        markedAddressList.append(address);
-        processor->queueBookmarkData(markedAddressList);
+      if (!markedAddresses.test(address)) {
+        markedAddresses.set(address);
+        processor->queueBookmarkData(markedAddresses);
         processor->addAction(Action{ActionType::UPDATEBOOKMARKS, 0});
       }
       ColorType type = (address == runtimeMarkerAddress) ? ColorType::MARKED_CURRENTINSTRUCTION : ColorType::MARKED;
@@ -170,20 +178,29 @@ void MainWindow::toggleCodeMarker(int line) {
   drawTextMarkers();
 }
 
-void MainWindow::setCurrentInstructionMarker(int address) {
-  ColorType type = markedAddressList.contains(address) ? ColorType::MARKED_CURRENTINSTRUCTION : ColorType::CURRENTINSTRUCTION;
+/**
+ * @brief Moves the current instruction marker to an address, in the window of the given bank.
+ *
+ * Only the previous and the new cell are recolored, the code markers are redrawn only when the
+ * marker moves to a different line.
+ */
+void MainWindow::setCurrentInstructionMarker(int address, int bank) {
+  ColorType type = markedAddresses.test(address) ? ColorType::MARKED_CURRENTINSTRUCTION : ColorType::CURRENTINSTRUCTION;
   colorMemory(address, type);
 
   if (address != runtimeMarkerAddress) {
-    if (markedAddressList.contains(runtimeMarkerAddress)) {
+    if (markedAddresses.test(runtimeMarkerAddress)) {
       colorMemory(runtimeMarkerAddress, ColorType::MARKED);
     } else {
       colorMemory(runtimeMarkerAddress, ColorType::NONE);
     }
   }
   runtimeMarkerAddress = address;
+  runtimeMarkerBank = bank;
 
-  drawTextMarkers();
+  if (errorDisplayed || assemblyMap.getObjectByAddress(address, bank).lineNumber != runtimeMarkerLine) {
+    drawTextMarkers();
+  }
 }
 
 void MainWindow::setAssemblyErrorMarker(int charNum, int lineNum) {
@@ -207,7 +224,6 @@ void MainWindow::setAssemblyErrorMarker(int charNum, int lineNum) {
   int scrollValue = ui->plainTextCode->verticalScrollBar()->value();
   int scrollAdjustment = (lineNum > scrollValue + autoScrollUpLimit) ? autoScrollUpLimit : autoScrollDownLimit;
 
-  ui->plainTextLines->verticalScrollBar()->setValue(lineNum - scrollAdjustment);
   ui->plainTextCode->verticalScrollBar()->setValue(lineNum - scrollAdjustment);
 }
 
@@ -216,8 +232,11 @@ void MainWindow::clearCodeMarkers() {
   colorMemory(runtimeMarkerAddress, ColorType::NONE);
   if (memoryDisplayMode == MemoryDisplayMode::FULL) {
     colorMemory(runtimeMarkerAddress, ColorType::NONE);
-    for (int i = 0; i < markedAddressList.length(); ++i) {
-      colorMemory(markedAddressList[i], ColorType::NONE);
+    for (int line : markedLines) {
+      int address = assemblyMap.getObjectByLine(line).address;
+      if (address >= 0) {
+        colorMemory(address, ColorType::NONE);
+      }
     }
   } else if (memoryDisplayMode == MemoryDisplayMode::SIMPLE) {
     for (int i = 0; i < 20; ++i) {
@@ -226,18 +245,20 @@ void MainWindow::clearCodeMarkers() {
       ui->tableWidgetSM->item(i, 2)->setBackground(QBrush(Core::SMMemoryCellColor));
     }
   }
-  markedLineList.clear();
-  markedAddressList.clear();
-  processor->queueBookmarkData(markedAddressList);
+  markedLines.clear();
+  markedAddresses.reset();
+  processor->queueBookmarkData(markedAddresses);
   processor->addAction(Action{ActionType::UPDATEBOOKMARKS, 0});
 
   runtimeMarkerAddress = 0;
-  ui->plainTextLines->setExtraSelections({});
+  runtimeMarkerBank = 0;
+  runtimeMarkerLine = -1;
+  ui->lineGutter->setLineMarkers({});
   ui->plainTextCode->setExtraSelections({});
   drawMemoryMarkers();
 }
 
 void MainWindow::clearMarkers() {
   clearCodeMarkers();
-  setCurrentInstructionMarker(processor->PC);
+  setCurrentInstructionMarker(processor->PC, processor->banks.selectedBank());
 }
@@ -14,6 +14,7 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include "src/assembler/Disassembler.h"
 #include "src/mainwindow/MainWindow.h"
 #include "src/processor/Processor.h"
 #include "ui_MainWindow.h"
@@ -23,9 +24,24 @@
 
 using Core::MsgType;
 
+/**
+ * @brief Saves the address space, followed by banks 1 and up when memory is banked.
+ *
+ * The bank window of the saved address space holds bank 0, whichever bank is mapped.
+ */
 void MainWindow::saveMemory() {
   processor->stopExecution();
   QByteArray byteArray(reinterpret_cast<const char *>(processor->Memory.data()), processor->Memory.size());
+  const Core::BankLayout &banks = processor->banks.layout();
+  for (int bank = 0; bank < banks.bankCount; ++bank) {
+    std::vector<uint8_t> contents = processor->banks.contents(bank);
+    QByteArray bytes(reinterpret_cast<const char *>(contents.data()), contents.size());
+    if (bank == 0) {
+      byteArray.replace(banks.windowStart, banks.windowSize, bytes);
+    } else {
+      byteArray.append(bytes);
+    }
+  }
   QString filePath = QFileDialog::getSaveFileName(this, tr("Save File"), "", tr("Binary Files (*.bin);;All Files (*)"));
 
   if (!filePath.isEmpty()) {
@@ -38,6 +54,46 @@ void MainWindow::saveMemory() {
     }
   }
 }
+void MainWindow::exportDisassembly() {
+  processor->stopExecution();
+  QString filePath = QFileDialog::getSaveFileName(this, tr("Export Disassembly"), "", tr("Listing Files (*.lst *.txt);;All Files (*)"));
+
+  if (!filePath.isEmpty()) {
+    QFile file(filePath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+      QTextStream out(&file);
+      Disassembler::writeListing(processorVersion, 0, 0xFFFF, processor->Memory, out);
+      file.close();
+      PrintConsole("Disassembly exported: " + filePath + '\n', MsgType::DEBUG);
+    } else {
+      PrintConsole("Error exporting disassembly", MsgType::ERROR);
+    }
+  }
+}
+/**
+ * @brief Maps an image file into the block storage device, read-write when the file allows it.
+ */
+void MainWindow::insertDiskImage() {
+  QString filePath = QFileDialog::getOpenFileName(this, tr("Insert Disk Image"), "", tr("Disk Images (*.img *.dsk *.bin);;All Files (*)"));
+  if (filePath.isEmpty()) {
+    return;
+  }
+  QString error;
+  std::shared_ptr<DiskImage> image = DiskImage::open(filePath, false, error);
+  if (image == nullptr) {
+    PrintConsole("Error inserting disk image: " + error, MsgType::ERROR);
+    return;
+  }
+  processor->storage.insert(image);
+  processor->addAction(Core::Action{Core::ActionType::SETBLOCKIMAGE, 0});
+  PrintConsole(QString("Disk image inserted: %1 (%2 sectors%3)\n").arg(filePath).arg(image->sectorCount()).arg(image->isReadOnly() ? ", read-only" : ""), MsgType::DEBUG);
+}
+
+void MainWindow::ejectDiskImage() {
+  processor->storage.insert(nullptr);
+  processor->addAction(Core::Action{Core::ActionType::SETBLOCKIMAGE, 0});
+}
+
 void MainWindow::loadMemory() {
   QString filePath = QFileDialog::getOpenFileName(this, tr("Open File"), "", tr("Binary Files (*.bin);;All Files (*)"));
 
@@ -45,10 +101,18 @@ void MainWindow::loadMemory() {
     QFile file(filePath);
     if (file.open(QIODevice::ReadOnly)) {
       QByteArray byteArray = file.readAll();
-      if (byteArray.size() == sizeof(processor->Memory)) {
+      const Core::BankLayout &banks = processor->banks.layout();
+      qsizetype bankedSize = sizeof(processor->Memory) + static_cast<qsizetype>(std::max(0, banks.bankCount - 1)) * banks.windowSize;
+      if (byteArray.size() == sizeof(processor->Memory) || byteArray.size() == bankedSize) {
         processor->stopExecution();
         std::memcpy(processor->Memory.data(), byteArray.constData(), sizeof(processor->Memory));
         std::memcpy(processor->backupMemory.data(), processor->Memory.data(), processor->Memory.size() * sizeof(uint8_t));
+        std::map<int, std::vector<uint8_t>> bankContents;
+        for (qsizetype offset = sizeof(processor->Memory); offset < byteArray.size(); offset += banks.windowSize) {
+          const uint8_t *bytes = reinterpret_cast<const uint8_t *>(byteArray.constData()) + offset;
+          bankContents[static_cast<int>(bankContents.size()) + 1].assign(bytes, bytes + banks.windowSize);
+        }
+        processor->banks.setInitialContents(bankContents);
         setAssemblyStatus(false);
 
       } else {
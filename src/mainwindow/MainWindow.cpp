@@ -17,18 +17,36 @@
 #include "src/mainwindow/MainWindow.h"
 #include "src/assembler/Assembler.h"
 #include "src/assembler/Disassembler.h"
+#include "src/assembler/FlowAnalyzer.h"
+#include "src/assembler/TimingAnalyzer.h"
+#include "src/dialogs/CharacterDisplay.h"
 #include "src/dialogs/ExternalDisplay.h"
 #include "src/dialogs/FocusAwareLineEdit.h"
+#include "src/dialogs/FramebufferDisplay.h"
 #include "src/dialogs/InstructionInfoDialog.h"
+#include "src/dialogs/LineGutter.h"
+#include "src/dialogs/PerformanceDialog.h"
+#include "src/dialogs/SerialConsole.h"
+#include "src/mainwindow/CodeHighlighter.h"
+#include "src/mainwindow/MemoryTableModel.h"
 #include "src/processor/Processor.h"
+#include "src/utils/AutosaveWriter.h"
 #include "ui_MainWindow.h"
+#include <QComboBox>
+#include <QDialogButtonBox>
 #include <QFileDialog>
+#include <QFormLayout>
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QMovie>
 #include <QObject>
 #include <QScrollBar>
+#include <QSpinBox>
+#include <QTextBlock>
 #include <QTimer>
+#include <QToolTip>
+#include <QWheelEvent>
+#include <QWindow>
 
 using Core::Action;
 using Core::ActionType;
@@ -60,7 +78,6 @@ MainWindow::MainWindow(
   ui->menuMemoryDisplayMode->setCurrentIndex(2);
   setupOPCTree();
   setupIndicators();
-  setupScrollbarConnections();
   setupEventFilters();
   setupCodeEditor();
   setupProcessorConnections();
@@ -73,20 +90,21 @@ MainWindow::MainWindow(
 
 void MainWindow::setupExternalDisplay() {
   externalDisplay = new ExternalDisplay(this);
-  plainTextDisplay = externalDisplay->getPlainTextEdit();
   connect(externalDisplay, &QDialog::finished, this, [=]() { ui->menuDisplayStatus->setCurrentIndex(0); });
+  performanceDialog = new PerformanceDialog(this);
+  serialConsole = new SerialConsole(processor, this);
 }
 void MainWindow::setupMemoryTable() {
   // Constants
   const int memCellWidth = 28;
   const int memCellHeight = 20;
-  const int fontSize = 9;
-  const QString font = "Lucida Console";
-  QFont cellFont(font, fontSize, QFont::Bold);
+
+  memoryModel = new MemoryTableModel(this);
+  ui->tableViewMemory->setModel(memoryModel);
 
   // Set table dimensions - use the same size for min/max/default
-  auto *hHeader = ui->tableWidgetMemory->horizontalHeader();
-  auto *vHeader = ui->tableWidgetMemory->verticalHeader();
+  auto *hHeader = ui->tableViewMemory->horizontalHeader();
+  auto *vHeader = ui->tableViewMemory->verticalHeader();
 
   hHeader->setMinimumSectionSize(memCellWidth);
   hHeader->setMaximumSectionSize(memCellWidth);
@@ -96,39 +114,9 @@ void MainWindow::setupMemoryTable() {
   vHeader->setMaximumSectionSize(memCellHeight);
   vHeader->setDefaultSectionSize(memCellHeight);
 
-  // Style column headers
-  for (int col = 0; col < ui->tableWidgetMemory->columnCount(); ++col) {
-    QTableWidgetItem *header = ui->tableWidgetMemory->horizontalHeaderItem(col);
-    header->setBackground(QBrush(QColor(210, 210, 255)));
-    header->setTextAlignment(Qt::AlignCenter);
-    header->setFont(cellFont);
-  }
-
-  // Initialize memory cells (rows and columns)
-  for (int row = 0; row <= 0xFFF; ++row) {
-    ui->tableWidgetMemory->insertRow(row);
-
-    // Set row header (address)
-    QString address = QString("%1").arg(row * 16, 4, 16, QChar('0')).toUpper();
-    QTableWidgetItem *rowHeader = new QTableWidgetItem(address);
-    rowHeader->setTextAlignment(Qt::AlignCenter);
-    rowHeader->setBackground(QBrush(QColor(210, 210, 255)));
-    rowHeader->setFont(cellFont);
-    ui->tableWidgetMemory->setVerticalHeaderItem(row, rowHeader);
-
-    // Initialize memory cells in this row
-    for (int col = 0; col < ui->tableWidgetMemory->columnCount(); ++col) {
-      QTableWidgetItem *cell = new QTableWidgetItem("00");
-      cell->setBackground(QBrush(Core::memoryCellDefaultColor));
-      cell->setTextAlignment(Qt::AlignCenter);
-      cell->setFont(cellFont);
-      cell->setFlags(cell->flags() & ~(Qt::ItemIsEditable | Qt::ItemIsUserCheckable));
-      ui->tableWidgetMemory->setItem(row, col, cell);
-    }
-  }
-
-  ui->tableWidgetMemory->setTextElideMode(Qt::ElideNone);
+  ui->tableViewMemory->setTextElideMode(Qt::ElideNone);
 }
+
 void MainWindow::setupSimpleMemory() {
   ui->groupSimpleMemory->setVisible(false);
   ui->groupSimpleMemory->setEnabled(false);
@@ -179,17 +167,12 @@ void MainWindow::setupIndicators() {
   ui->labelAt->setVisible(false);
   ui->menuBreakAt->setVisible(false);
 }
-void MainWindow::setupScrollbarConnections() {
-  connect(ui->plainTextCode->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::handleCodeVerticalScrollBarValueChanged);
-  connect(ui->plainTextLines->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::handleLinesScroll);
-  connect(ui->plainTextDisplay->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::handleDisplayScrollVertical);
-  connect(ui->plainTextDisplay->horizontalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::handleDisplayScrollHorizontal);
-}
 void MainWindow::setupEventFilters() {
-  ui->plainTextDisplay->installEventFilter(this);
-  ui->plainTextLines->installEventFilter(this);
-  plainTextDisplay->installEventFilter(this);
-  ui->tableWidgetMemory->installEventFilter(this);
+  ui->characterDisplay->installEventFilter(this);
+  externalDisplay->getCharacterDisplay()->installEventFilter(this);
+  externalDisplay->getFramebufferDisplay()->installEventFilter(this);
+  ui->tableViewMemory->installEventFilter(this);
+  ui->tableViewMemory->viewport()->installEventFilter(this);
 }
 void MainWindow::setupCodeEditor() {
   // Configure code editor properties
@@ -197,13 +180,36 @@ void MainWindow::setupCodeEditor() {
   connect(ui->plainTextCode, &QPlainTextEdit::customContextMenuRequested, this, &MainWindow::showContextMenu);
   ui->plainTextCode->setUndoRedoEnabled(true);
   ui->plainTextCode->moveCursor(QTextCursor::End);
+  highlighter = new CodeHighlighter(ui->plainTextCode);
+  autosaveWriter = new AutosaveWriter(QCoreApplication::applicationDirPath() + "/autosave", "backup_session_" + sessionId, ui->plainTextCode->toPlainText(), this);
+  connect(ui->plainTextCode->document(), &QTextDocument::contentsChange, this, [this](int position, int charsRemoved, int charsAdded) {
+    // only the changed range is copied, the writer thread keeps the rest of the text
+    QTextCursor cursor(ui->plainTextCode->document());
+    cursor.setPosition(position);
+    cursor.setPosition(std::min(position + charsAdded, ui->plainTextCode->document()->characterCount() - 1), QTextCursor::KeepAnchor);
+    autosaveWriter->recordEdit(position, charsRemoved, cursor.selectedText().replace(QChar::ParagraphSeparator, '\n'));
+  });
+  ui->lineGutter->setEditor(ui->plainTextCode);
+  connect(ui->lineGutter, &LineGutter::lineClicked, this, [this](int line, Qt::MouseButton button) {
+    if (!assembled) {
+      return;
+    }
+    if (button == Qt::LeftButton) {
+      toggleCodeMarker(line);
+    } else if (button == Qt::RightButton) {
+      clearCodeMarkers();
+    }
+  });
 
   // Set tab width based on font metrics
   QFontMetrics metrics(ui->plainTextCode->font());
   ui->plainTextCode->setTabStopDistance(metrics.horizontalAdvance(' ') * ui->spinBoxTabWidth->value());
 }
 void MainWindow::setupProcessorConnections() {
-  connect(processor, &Processor::uiUpdateData, this, &MainWindow::drawProcessorRunning);
+  runningSnapshot = std::make_unique<Core::ProcessorSnapshot>();
+  refreshTimer = new QTimer(this);
+  refreshTimer->setTimerType(Qt::PreciseTimer);
+  connect(refreshTimer, &QTimer::timeout, this, &MainWindow::refreshRunningView);
   connect(processor, &Processor::executionStopped, this, &MainWindow::onExecutionStopped);
 }
 void MainWindow::setupMemoryCornerWidget() {
@@ -247,6 +253,27 @@ void MainWindow::setupMenus() {
   // EMULATOR MENU
   QMenu *emulationMenu = menuBar()->addMenu(tr("&Emulator"));
   createAction(emulationMenu, tr("Assemble"), QKeySequence(Qt::Key_F9), [this]() { on_buttonAssemble_clicked(); });
+  QAction *optimizeDirect = createAction(emulationMenu, tr("Optimize Direct Addressing"), QKeySequence(), [this]() {
+    assemblyOptions.optimizeDirectAddressing = !assemblyOptions.optimizeDirectAddressing;
+    setAssemblyStatus(false);
+  });
+  optimizeDirect->setCheckable(true);
+  optimizeDirect->setChecked(assemblyOptions.optimizeDirectAddressing);
+  QAction *optimizePeephole = createAction(emulationMenu, tr("Peephole Optimization"), QKeySequence(), [this]() {
+    assemblyOptions.peepholeOptimization = !assemblyOptions.peepholeOptimization;
+    setAssemblyStatus(false);
+  });
+  optimizePeephole->setCheckable(true);
+  optimizePeephole->setChecked(assemblyOptions.peepholeOptimization);
+  createAction(emulationMenu, tr("Analyze Cycles"), QKeySequence(), [this]() { printCycleAnalysis(); });
+  createAction(emulationMenu, tr("Analyze Interrupt Timing"), QKeySequence(), [this]() { printInterruptTimingAnalysis(); });
+  createAction(emulationMenu, tr("Set Latency Budget..."), QKeySequence(), [this]() {
+    bool ok;
+    int budget = QInputDialog::getInt(this, tr("Latency Budget"), tr("Maximum cycles of an interrupt handler (0 disables the check):"), latencyBudget, 0, 10000000, 1, &ok);
+    if (ok) {
+      latencyBudget = budget;
+    }
+  });
   emulationMenu->addSeparator();
   createAction(emulationMenu, tr("Run/Stop"), QKeySequence(Qt::Key_F5), [this]() { on_buttonRunStop_clicked(); });
   createAction(emulationMenu, tr("Step"), QKeySequence(Qt::Key_F6), [this]() { on_buttonStep_clicked(); });
@@ -258,6 +285,11 @@ void MainWindow::setupMenus() {
   saveMemoryAction = createAction(emulationMenu, tr("Save Memory"), QKeySequence(), &MainWindow::saveMemory);
   saveMemoryAction->setEnabled(writingMode == WritingMode::MEMORY);
 
+  createAction(emulationMenu, tr("Export Disassembly"), QKeySequence(), &MainWindow::exportDisassembly);
+  createAction(emulationMenu, tr("Insert Disk Image..."), QKeySequence(), &MainWindow::insertDiskImage);
+  createAction(emulationMenu, tr("Eject Disk Image"), QKeySequence(), &MainWindow::ejectDiskImage);
+  createAction(emulationMenu, tr("Memory Banks..."), QKeySequence(), [this]() { configureMemoryBanks(); });
+
   emulationMenu->addSeparator();
   createAction(emulationMenu, tr("Switch Writing Mode"), QKeySequence(Qt::CTRL | Qt::Key_M), [this]() {
     if (writingMode == WritingMode::MEMORY) {
@@ -289,6 +321,26 @@ void MainWindow::setupMenus() {
 
   viewMenu->addSeparator();
   createAction(viewMenu, tr("Switch Display Mode"), QKeySequence(), [this]() { ui->menuDisplayStatus->setCurrentIndex((ui->menuDisplayStatus->currentIndex() + 1) % ui->menuDisplayStatus->count()); });
+  QAction *framebufferMode = createAction(viewMenu, tr("Framebuffer Mode"), QKeySequence(), [this]() {
+    bool enabled = !externalDisplay->isFramebufferMode();
+    externalDisplay->setFramebufferMode(enabled);
+    if (enabled && displayStatusIndex != 2) {
+      ui->menuDisplayStatus->setCurrentIndex(ui->menuDisplayStatus->count() - 1);
+    }
+    externalDisplay->setMemory(processor->Memory);
+  });
+  framebufferMode->setCheckable(true);
+  framebufferMode->setChecked(false);
+  createAction(viewMenu, tr("Framebuffer Settings..."), QKeySequence(), [this]() { configureFramebuffer(); });
+  viewMenu->addSeparator();
+  createAction(viewMenu, tr("Performance"), QKeySequence(), [this]() {
+    performanceDialog->show();
+    performanceDialog->raise();
+  });
+  createAction(viewMenu, tr("Serial Console"), QKeySequence(), [this]() {
+    serialConsole->show();
+    serialConsole->raise();
+  });
 
   // ABOUT MENU
   QMenu *aboutMenu = menuBar()->addMenu(tr("&About"));
@@ -388,6 +440,7 @@ void MainWindow::applyInitialSettings() {
 MainWindow::~MainWindow() {
   processor->stopExecution();
   QCoreApplication::processEvents();
+  delete serialConsole; // its host thread uses the processor's ACIA
   delete processor;
   delete ui;
 }
@@ -426,14 +479,6 @@ void MainWindow::setWritingMode(WritingMode mode) {
     ui->buttonLoad->setText("Load Memory");
     ui->buttonSave->setText("Save Memory");
     ui->buttonAssemble->setText("Disassemble");
-
-    for (int row = 0; row < ui->tableWidgetMemory->rowCount(); row++) {
-      for (int col = 0; col < ui->tableWidgetMemory->columnCount(); col++) {
-        QTableWidgetItem *item = ui->tableWidgetMemory->item(row, col);
-        // item->setFlags(item->flags() | Qt::ItemIsEditable);
-        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
-      }
-    }
   } else {
     ui->plainTextCode->setReadOnly(false);
     ui->checkAssembleOnRun->setEnabled(true);
@@ -443,14 +488,6 @@ void MainWindow::setWritingMode(WritingMode mode) {
     ui->buttonLoad->setText("Load Code");
     ui->buttonSave->setText("Save Code");
     ui->buttonAssemble->setText("Assemble");
-
-    for (int row = 0; row < ui->tableWidgetMemory->rowCount(); row++) {
-      for (int col = 0; col < ui->tableWidgetMemory->columnCount(); col++) {
-        QTableWidgetItem *item = ui->tableWidgetMemory->item(row, col);
-        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
-        item->setFlags(item->flags() & ~Qt::ItemIsUserCheckable);
-      }
-    }
   }
 
   loadMemoryAction->setEnabled(mode == WritingMode::MEMORY);
@@ -517,20 +554,24 @@ void MainWindow::showContextMenu(const QPoint &pos) {
 }
 
 void MainWindow::showMnemonicInfo(int cursorPos) {
-  const QString plainText = ui->plainTextCode->toPlainText();
-
-  if (cursorPos < 0 || cursorPos >= plainText.length()) {
+  QTextBlock block = ui->plainTextCode->document()->findBlock(cursorPos);
+  if (cursorPos < 0 || !block.isValid()) {
+    return;
+  }
+  const QString lineText = block.text();
+  int linePos = cursorPos - block.position();
+  if (linePos >= lineText.length()) {
     return;
   }
 
-  int right = cursorPos;
-  int left = cursorPos;
-  while (right < plainText.length() && !plainText[right].isSpace())
+  int right = linePos;
+  int left = linePos;
+  while (right < lineText.length() && !lineText[right].isSpace())
     right++;
-  while (left >= 0 && !plainText[left].isSpace())
+  while (left >= 0 && !lineText[left].isSpace())
     left--;
 
-  QString word = plainText.mid(left + 1, right - left - 1).toUpper();
+  QString word = lineText.mid(left + 1, right - left - 1).toUpper();
   if (Core::isMnemonic(word)) {
     showInstructionInfoWindow(word);
   }
@@ -560,18 +601,6 @@ void MainWindow::showInstructionInfoWindow(QString instruction) {
   dialog.exec();
 }
 
-QString MainWindow::getDisplayText(std::array<uint8_t, 0x10000> &memory) {
-  QString text;
-  for (uint16_t i = 0; i < 20 * 54; ++i) {
-    uint8_t val = memory[i + 0xFB00];
-    QChar c = Core::numToChar(val);
-    text.append(c.isNull() ? ' ' : c);
-    if ((i + 1) % 54 == 0)
-      text.append("\n");
-  }
-  return text;
-}
-
 void MainWindow::setAssemblyStatus(bool isAssembled) {
   if (isAssembled) {
     ui->buttonAssemble->setStyleSheet(greenButton);
@@ -581,111 +610,55 @@ void MainWindow::setAssemblyStatus(bool isAssembled) {
     ui->buttonAssemble->setStyleSheet(redButton);
     assemblyMap.clear();
     clearMarkers();
-    ui->plainTextLines->verticalScrollBar()->setValue(ui->plainTextCode->verticalScrollBar()->value());
   }
-  updateLinesBox(true);
+  ui->lineGutter->setAssemblyMap(&assemblyMap, processorVersion);
   updateMemoryTab();
   drawMemoryMarkers();
   drawTextMarkers();
-  setCurrentInstructionMarker(processor->PC);
+  setCurrentInstructionMarker(processor->PC, processor->banks.selectedBank());
 }
 
-void MainWindow::updateLinesBox(bool redraw) {
-  QString code = ui->plainTextCode->toPlainText();
-  QString text;
-  int rowCount = code.count("\n") + 1;
-  if (redraw) {
-    if (ui->checkAdvancedInfo->isChecked()) {
-      for (int i = 0; i < rowCount; i++) {
-        const AssemblyMap::MappedInstr &instr = assemblyMap.getObjectByLine(i);
-        if (instr.address == -1) {
-          text += QString("%1:----\n").arg(i, 5, 10, QChar('0'));
-        } else {
-          int length = getInstructionLength(processorVersion, instr.byte1);
-          QString advancedString = QString("%1:%2").arg(i, 5, 10, QChar('0')).arg(instr.address, 4, 16, QChar('0'));
-          if (length > 0)
-            advancedString += ":" + QString("%1").arg(instr.byte1, 2, 16, QChar('0'));
-          if (length > 1)
-            advancedString += ":" + QString("%1").arg(instr.byte2, 2, 16, QChar('0'));
-          if (length > 2)
-            advancedString += ":" + QString("%1").arg(instr.byte3, 2, 16, QChar('0'));
-          text += advancedString + "\n";
-        }
-      }
-    } else {
-      for (int i = 0; i < rowCount; i++) {
-        if (assemblyMap.getObjectByLine(i).address == -1) {
-          text += QString("%1:----\n").arg(i, 5, 10, QChar('0'));
-        } else {
-          text += QString("%1:%2\n").arg(i, 5, 10, QChar('0')).arg(assemblyMap.getObjectByLine(i).address, 4, 16, QChar('0'));
-        }
-      }
-    }
-  } else {
-    int previousRowCount = ui->plainTextLines->toPlainText().count("\n");
-    if (rowCount > previousRowCount) {
-      text = ui->plainTextLines->toPlainText();
-      for (int i = previousRowCount; i < rowCount; i++) {
-        text += QString("%1:----\n").arg(i, 5, 10, QChar('0'));
-      }
-    } else if (rowCount < previousRowCount) {
-      QStringList list = ui->plainTextLines->toPlainText().split('\n');
-      list = list.mid(0, rowCount);
-      text = list.join('\n').append('\n');
-    } else {
-      return;
-    }
-  }
-  ui->plainTextLines->setPlainText(text);
-  ui->plainTextLines->verticalScrollBar()->setValue(ui->plainTextCode->verticalScrollBar()->value());
-}
 void MainWindow::updateMemoryTab() {
   if (memoryDisplayMode == MemoryDisplayMode::SIMPLE) {
-    for (int i = 0; i < 20; ++i) {
-      ui->tableWidgetSM->item(i, 2)->setText("");
-    }
     for (int i = 0; i < 20; ++i) {
       uint16_t adr = static_cast<uint16_t>(std::clamp(currentSMScroll + i, 0, 0xFFFF));
 
       ui->tableWidgetSM->item(i, 0)->setText(QString("%1").arg(adr, 4, 16, QChar('0')).toUpper());
       ui->tableWidgetSM->item(i, 1)->setText(QString("%1").arg(processor->Memory[adr], 2, 16, QChar('0')).toUpper());
-
-      if (assembled) {
-        auto instruction = assemblyMap.getObjectByAddress(adr);
-
-        if (instruction.lineNumber == -1) {
-          continue;
-        }
-
-        int length = getInstructionLength(processorVersion, instruction.byte1);
-
-        if (length == 0) {
-          continue;
-        }
-
-        ui->tableWidgetSM->item(i, 2)->setText(instruction.IN);
-
-        if (length > 1 && i + 1 < 20) {
-          ui->tableWidgetSM->item(i + 1, 2)->setText(QString("%1").arg(instruction.byte2, 2, 16, QChar('0')).toUpper());
-        }
-        if (length > 2 && i + 2 < 20) {
-          ui->tableWidgetSM->item(i + 2, 2)->setText(QString("%1").arg(instruction.byte3, 2, 16, QChar('0')).toUpper());
-        }
-      }
     }
+    drawSimpleMemoryInstructions(processor->Memory, processor->banks.selectedBank());
   } else if (memoryDisplayMode == MemoryDisplayMode::FULL) {
-    for (int row = 0; row < ui->tableWidgetMemory->rowCount(); ++row) {
-      for (int col = 0; col < ui->tableWidgetMemory->columnCount(); ++col) {
-        uint16_t adr = static_cast<uint16_t>(row * 16 + col);
-        int value = processor->Memory[adr];
+    memoryModel->setHexadecimal(hexReg);
+    memoryModel->setMappedBank(processor->banks.selectedBank());
+    memoryModel->setMemory(processor->Memory);
+  }
+}
 
-        if (hexReg) {
-          ui->tableWidgetMemory->item(row, col)->setText(QString("%1").arg(value, 2, 16, QChar('0')).toUpper());
-        } else {
-          ui->tableWidgetMemory->item(row, col)->setText(QString("%1").arg(value));
-        }
+/**
+ * @brief Fills the description column of the simple memory view, decoding only the visible rows.
+ */
+void MainWindow::drawSimpleMemoryInstructions(const std::array<uint8_t, 0x10000> &memory, int bank) {
+  int nextInstruction = std::clamp(currentSMScroll, 0, 0xFFFF);
+  disassemblyCache.sync(processorVersion, nextInstruction, 20, memory);
+  for (int i = 0; i < 20; ++i) {
+    int adr = std::clamp(currentSMScroll + i, 0, 0xFFFF);
+    if (assembled) {
+      const auto &instruction = assemblyMap.getObjectByAddress(adr, bank);
+      if (instruction.lineNumber != -1) {
+        bool isData = Core::directivesWithLocation.contains(instruction.IN) || instruction.IN == "BYTE";
+        nextInstruction = isData ? -1 : adr;
       }
     }
+
+    if (adr == nextInstruction) {
+      const Disassembler::DecodedLine &line = disassemblyCache.decodeLine(adr, memory);
+      ui->tableWidgetSM->item(i, 2)->setText(line.valid ? line.mnemonic : "");
+      nextInstruction = adr + line.length;
+    } else if (nextInstruction > adr) {
+      ui->tableWidgetSM->item(i, 2)->setText(QString("%1").arg(memory[adr], 2, 16, QChar('0')).toUpper());
+    } else {
+      ui->tableWidgetSM->item(i, 2)->setText("");
+    }
   }
 }
 
@@ -726,11 +699,11 @@ void MainWindow::resizeEvent(QResizeEvent *event) {
   }
 }
 
-void MainWindow::showMemoryEditor(const QList<QTableWidgetItem *> &selectedItems, const QString &initialText, bool selectAll) {
-  QTableWidgetItem *mainItem = selectedItems.last();
-  const QString &originalText = mainItem->text();
-  QRect cellRect = ui->tableWidgetMemory->visualItemRect(mainItem);
-  FocusAwareLineEdit *editor = new FocusAwareLineEdit(ui->tableWidgetMemory->viewport(), ui->tableWidgetMemory);
+void MainWindow::showMemoryEditor(const QModelIndexList &selectedIndexes, const QString &initialText, bool selectAll) {
+  QModelIndex mainIndex = selectedIndexes.last();
+  const QString originalText = mainIndex.data().toString();
+  QRect cellRect = ui->tableViewMemory->visualRect(mainIndex);
+  FocusAwareLineEdit *editor = new FocusAwareLineEdit(ui->tableViewMemory->viewport(), ui->tableViewMemory);
   editor->setGeometry(cellRect);
   editor->setFrame(false);
   editor->setAlignment(Qt::AlignCenter);
@@ -754,14 +727,14 @@ void MainWindow::showMemoryEditor(const QList<QTableWidgetItem *> &selectedItems
       uint32_t valueTemp = hexReg ? input.toUInt(&ok, 16) : input.toUInt(&ok, 10);
       if (ok && valueTemp <= 255) {
         uint8_t value = valueTemp;
-        if (selectedItems.size() == 1) {
+        if (selectedIndexes.size() == 1) {
 
-          uint16_t adr = static_cast<uint16_t>(mainItem->row() * 16 + mainItem->column());
+          uint16_t adr = static_cast<uint16_t>(MemoryTableModel::addressOf(mainIndex));
           processor->addAction(Action{ActionType::SETMEMORY, static_cast<uint32_t>(adr | value << 16)});
         } else {
           QVector<uint16_t> addresses;
-          for (QTableWidgetItem *item : selectedItems) {
-            uint16_t adr = static_cast<uint16_t>(item->row() * 16 + item->column());
+          for (const QModelIndex &index : selectedIndexes) {
+            uint16_t adr = static_cast<uint16_t>(MemoryTableModel::addressOf(index));
             addresses.append(adr);
           }
           processor->setMemoryUpdate(addresses, value);
@@ -769,39 +742,16 @@ void MainWindow::showMemoryEditor(const QList<QTableWidgetItem *> &selectedItems
         }
         updateMemoryTab();
         if (displayStatusIndex == 1) {
-          ui->plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+          ui->characterDisplay->setMemory(processor->Memory);
         } else if (displayStatusIndex == 2) {
-          plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+          externalDisplay->setMemory(processor->Memory);
         }
       }
     }
   });
 }
 bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
-  if (obj == ui->plainTextLines) {
-    if (event->type() == QEvent::MouseButtonPress) {
-      QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(event);
-      if (mouseEvent) {
-        if (assembled) {
-          if (mouseEvent->button() == Qt::LeftButton) {
-            QPoint mousePos = mouseEvent->pos();
-            QTextCursor cursor = ui->plainTextLines->cursorForPosition(mousePos);
-            if (!cursor.atEnd()) {
-              int lineNumber = cursor.blockNumber();
-              int totalLines = ui->plainTextLines->document()->blockCount();
-              if (lineNumber >= 0 && lineNumber < totalLines) {
-                toggleCodeMarker(lineNumber);
-              }
-            }
-          } else if (mouseEvent->button() == Qt::RightButton) {
-            clearCodeMarkers();
-          }
-        }
-      }
-    } else if (event->type() == QEvent::Wheel || event->type() == QEvent::Scroll || event->type() == QEvent::User || event->type() == QEvent::KeyPress) {
-      return true;
-    }
-  } else if (obj == plainTextDisplay || obj == ui->plainTextDisplay) {
+  if (obj == ui->characterDisplay || obj == externalDisplay->getCharacterDisplay() || obj == externalDisplay->getFramebufferDisplay()) {
     if (event->type() == QEvent::KeyPress) {
       QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
       int key = keyEvent->key();
@@ -834,33 +784,62 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
       }
       processor->addAction(Action{ActionType::SETKEY, asciiValue});
       return true;
-    } else if (event->type() == QMouseEvent::MouseButtonPress || event->type() == QMouseEvent::MouseButtonDblClick) {
+    } else if (event->type() == QMouseEvent::MouseButtonPress || event->type() == QMouseEvent::MouseButtonDblClick || event->type() == QMouseEvent::MouseButtonRelease) {
       QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(event);
-      if (mouseEvent->button() == Qt::LeftButton) {
-        processor->addAction(Action{ActionType::SETMOUSECLICK, 1});
-      } else if (mouseEvent->button() == Qt::RightButton) {
-        processor->addAction(Action{ActionType::SETMOUSECLICK, 2});
-      } else if (mouseEvent->button() == Qt::MiddleButton) {
-        processor->addAction(Action{ActionType::SETMOUSECLICK, 3});
+      QPoint position = mouseEvent->position().toPoint();
+      if (obj == externalDisplay->getFramebufferDisplay()) {
+        processDisplayInputs(externalDisplay->getFramebufferDisplay()->pixelAt(position));
+      } else {
+        processDisplayInputs(static_cast<CharacterDisplay *>(obj)->cellAt(position));
       }
-
+      uint8_t buttons = (mouseEvent->buttons() & Qt::LeftButton ? PointerDevice::leftButton : 0) |
+                        (mouseEvent->buttons() & Qt::RightButton ? PointerDevice::rightButton : 0) |
+                        (mouseEvent->buttons() & Qt::MiddleButton ? PointerDevice::middleButton : 0);
+      processor->pointer.setButtons(buttons);
+      if (event->type() != QMouseEvent::MouseButtonRelease) {
+        if (mouseEvent->button() == Qt::LeftButton) {
+          processor->pointer.click(1);
+        } else if (mouseEvent->button() == Qt::RightButton) {
+          processor->pointer.click(2);
+        } else if (mouseEvent->button() == Qt::MiddleButton) {
+          processor->pointer.click(3);
+        }
+      }
+      return true;
+    } else if (event->type() == QEvent::Wheel) {
+      processor->pointer.scroll(static_cast<QWheelEvent *>(event)->angleDelta().y());
       return true;
     }
-  } else if (obj == ui->tableWidgetMemory) {
+  } else if (obj == ui->tableViewMemory->viewport() && event->type() == QEvent::ToolTip) {
+    // attribute the byte under the cursor to the source line which wrote it
+    QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
+    QModelIndex index = ui->tableViewMemory->indexAt(helpEvent->pos());
+    AssemblyMap::AddressRange range = index.isValid() ? assemblyMap.getRangeContaining(MemoryTableModel::addressOf(index), memoryModel->displayedBank()) : AssemblyMap::AddressRange{-1, -1, -1};
+    if (!assembled || range.begin == -1) {
+      return false; // the view shows the model's tooltip, if the cell has one
+    }
+    QString source = ui->plainTextCode->document()->findBlockByNumber(range.lineNumber).text().trimmed();
+    QString text = QString("Line %1: %2").arg(range.lineNumber).arg(source);
+    QString cellTip = memoryModel->data(index, Qt::ToolTipRole).toString();
+    if (!cellTip.isEmpty()) {
+      text += "\n" + cellTip;
+    }
+    QToolTip::showText(helpEvent->globalPos(), text, ui->tableViewMemory->viewport());
+    return true;
+  } else if (obj == ui->tableViewMemory) {
     if (writingMode == WritingMode::MEMORY) {
       if (event->type() == QEvent::KeyPress) {
         QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
         if (keyEvent->key() == Qt::Key_Delete) {
-          auto selectedItems = ui->tableWidgetMemory->selectedItems();
-          if (!selectedItems.isEmpty()) {
-            if (selectedItems.size() == 1) {
-              QTableWidgetItem *item = selectedItems.first();
-              uint16_t adr = static_cast<uint16_t>(item->row() * 16 + item->column());
+          auto selectedIndexes = ui->tableViewMemory->selectionModel()->selectedIndexes();
+          if (!selectedIndexes.isEmpty()) {
+            if (selectedIndexes.size() == 1) {
+              uint16_t adr = static_cast<uint16_t>(MemoryTableModel::addressOf(selectedIndexes.first()));
               processor->addAction(Action{ActionType::SETMEMORY, static_cast<uint32_t>(adr)});
             } else {
               QVector<uint16_t> addresses;
-              for (QTableWidgetItem *item : selectedItems) {
-                uint16_t adr = static_cast<uint16_t>(item->row() * 16 + item->column());
+              for (const QModelIndex &index : selectedIndexes) {
+                uint16_t adr = static_cast<uint16_t>(MemoryTableModel::addressOf(index));
                 addresses.append(adr);
               }
               processor->setMemoryUpdate(addresses, 0x00);
@@ -868,24 +847,24 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
             }
             updateMemoryTab();
             if (displayStatusIndex == 1) {
-              ui->plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+              ui->characterDisplay->setMemory(processor->Memory);
             } else if (displayStatusIndex == 2) {
-              plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+              externalDisplay->setMemory(processor->Memory);
             }
           }
           return true;
         } else if (keyEvent->key() == Qt::Key_Return || keyEvent->key() == Qt::Key_Enter) {
-          auto selectedItems = ui->tableWidgetMemory->selectedItems();
-          if (!selectedItems.isEmpty()) {
-            showMemoryEditor(selectedItems, "", true);
+          auto selectedIndexes = ui->tableViewMemory->selectionModel()->selectedIndexes();
+          if (!selectedIndexes.isEmpty()) {
+            showMemoryEditor(selectedIndexes, "", true);
           }
           return true;
         } else if ((keyEvent->key() >= '0' && keyEvent->key() <= '9') ||
                    (keyEvent->key() >= 'A' && keyEvent->key() <= 'F') ||
                    (keyEvent->key() >= 'a' && keyEvent->key() <= 'f')) {
-          auto selectedItems = ui->tableWidgetMemory->selectedItems();
-          if (!selectedItems.isEmpty()) {
-            showMemoryEditor(selectedItems, keyEvent->text(), false);
+          auto selectedIndexes = ui->tableViewMemory->selectionModel()->selectedIndexes();
+          if (!selectedIndexes.isEmpty()) {
+            showMemoryEditor(selectedIndexes, keyEvent->text(), false);
             return true;
           }
         }
@@ -898,8 +877,8 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
 void MainWindow::resetEmulator() {
   processor->reset();
   drawProcessor();
-  ui->plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
-  plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+  ui->characterDisplay->setMemory(processor->Memory);
+  externalDisplay->setMemory(processor->Memory);
 }
 
 void MainWindow::drawProcessor() {
@@ -927,119 +906,130 @@ void MainWindow::drawProcessor() {
   }
   ui->lineEditTotalOpNum->setText(QString::number(processor->operationsSinceStart));
 
-  int lineNum = assemblyMap.getObjectByAddress(processor->PC).lineNumber;
+  int lineNum = assemblyMap.getObjectByAddress(processor->PC, processor->banks.selectedBank()).lineNumber;
   if (ui->checkAutoScroll->isChecked()) {
     if (lineNum >= 0) {
       if (lineNum > previousScrollCode + autoScrollUpLimit) {
         previousScrollCode = lineNum - autoScrollUpLimit;
-        ui->plainTextLines->verticalScrollBar()->setValue(previousScrollCode);
         ui->plainTextCode->verticalScrollBar()->setValue(previousScrollCode);
       } else if (lineNum < previousScrollCode + autoScrollDownLimit) {
         previousScrollCode = lineNum - autoScrollDownLimit;
-        ui->plainTextLines->verticalScrollBar()->setValue(previousScrollCode);
         ui->plainTextCode->verticalScrollBar()->setValue(previousScrollCode);
       }
     }
   }
 
   if (displayStatusIndex == 1) {
-    ui->plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+    ui->characterDisplay->setMemory(processor->Memory);
   } else if (displayStatusIndex == 2) {
-    plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+    externalDisplay->setMemory(processor->Memory);
   }
   updateMemoryTab();
-  setCurrentInstructionMarker(processor->PC);
+  setCurrentInstructionMarker(processor->PC, processor->banks.selectedBank());
 }
+/**
+ * @brief Publishes the pointer position over a display, the processor samples it at its own pace.
+ */
 void MainWindow::processDisplayInputs(
-  QPlainTextEdit *display) {
-  QPoint position = QCursor::pos();
-  QPoint localMousePos = display->mapFromGlobal(position);
-  localMousePos.setX(localMousePos.x() - 3);
-  localMousePos.setY(localMousePos.y() - 5);
-  QFontMetrics fontMetrics(display->font());
-  int charWidth = fontMetrics.averageCharWidth();
-  int charHeight = fontMetrics.height();
-  int x = localMousePos.x() / charWidth;
-  int y = localMousePos.y() / charHeight;
-  x = std::clamp(x, 0, 53);
-  y = std::clamp(y, 0, 19);
-  processor->Memory[0xFFF2] = static_cast<uint8_t>(x);
-  processor->Memory[0xFFF3] = static_cast<uint8_t>(y);
+  const QPoint &position) {
+  processor->pointer.setPosition(static_cast<uint8_t>(position.x()), static_cast<uint8_t>(position.y()));
+}
+/**
+ * @brief Pulls the latest processor snapshot and draws it, called on every display refresh while running.
+ *
+ * Nothing is drawn or requested while neither the main window nor the external display can be
+ * seen, so the execution thread does not even copy its state. A snapshot which is not taken
+ * before the next one is captured is simply replaced.
+ *
+ * Snapshots replaced before they were drawn, and refresh periods skipped by a late timer, are
+ * counted as dropped frames for the performance dialog. A refresh which finds no new snapshot
+ * is not, the execution thread may simply not have finished a batch yet.
+ */
+void MainWindow::refreshRunningView() {
+  qint64 interval = frameClock.restart();
+  if (refreshTimer->interval() > 0 && interval > refreshTimer->interval() * 3 / 2) {
+    droppedFrames += static_cast<int>(interval / refreshTimer->interval()) - 1;
+  }
+  bool mainVisible = !isMinimized() && windowHandle() && windowHandle()->isExposed();
+  bool externalVisible = displayStatusIndex == 2 && !externalDisplay->isMinimized() && externalDisplay->windowHandle() && externalDisplay->windowHandle()->isExposed();
+  if (!mainVisible && !externalVisible) {
+    return;
+  }
+  if (processor->takeSnapshot(runningSnapshot)) {
+    QElapsedTimer frameTime;
+    frameTime.start();
+    drawProcessorRunning(*runningSnapshot);
+    droppedFrames += runningSnapshot->replacedSnapshots;
+    performanceDialog->addFrame(*runningSnapshot, frameTime.nsecsElapsed(), droppedFrames);
+    droppedFrames = 0;
+  }
+  processor->requestSnapshot();
 }
 void MainWindow::drawProcessorRunning(
-  std::array<uint8_t, 0x10000> memory, int curCycle, uint8_t flags, uint16_t PC, uint16_t SP, uint8_t aReg, uint8_t bReg, uint16_t xReg, bool useCycles, uint64_t opertaionsSinceStart) {
-  ui->lineEditHValue->setText(QString::number(Core::bit(flags, 5)));
-  ui->lineEditIValue->setText(QString::number(Core::bit(flags, 4)));
-  ui->lineEditNValue->setText(QString::number(Core::bit(flags, 3)));
-  ui->lineEditZValue->setText(QString::number(Core::bit(flags, 2)));
-  ui->lineEditVValue->setText(QString::number(Core::bit(flags, 1)));
-  ui->lineEditCValue->setText(QString::number(Core::bit(flags, 0)));
+  const Core::ProcessorSnapshot &snapshot) {
+  ui->lineEditHValue->setText(QString::number(Core::bit(snapshot.flags, 5)));
+  ui->lineEditIValue->setText(QString::number(Core::bit(snapshot.flags, 4)));
+  ui->lineEditNValue->setText(QString::number(Core::bit(snapshot.flags, 3)));
+  ui->lineEditZValue->setText(QString::number(Core::bit(snapshot.flags, 2)));
+  ui->lineEditVValue->setText(QString::number(Core::bit(snapshot.flags, 1)));
+  ui->lineEditCValue->setText(QString::number(Core::bit(snapshot.flags, 0)));
   if (hexReg) {
-    ui->lineEditPCValue->setText(QString("%1").arg(PC, 4, 16, QLatin1Char('0')).toUpper());
-    ui->lineEditSPValue->setText(QString("%1").arg(SP, 4, 16, QLatin1Char('0')).toUpper());
-    ui->lineEditAValue->setText(QString("%1").arg(aReg, 2, 16, QLatin1Char('0')).toUpper());
-    ui->lineEditBValue->setText(QString("%1").arg(bReg, 2, 16, QLatin1Char('0')).toUpper());
-    ui->lineEditXValue->setText(QString("%1").arg(xReg, 4, 16, QLatin1Char('0')).toUpper());
+    ui->lineEditPCValue->setText(QString("%1").arg(snapshot.PC, 4, 16, QLatin1Char('0')).toUpper());
+    ui->lineEditSPValue->setText(QString("%1").arg(snapshot.SP, 4, 16, QLatin1Char('0')).toUpper());
+    ui->lineEditAValue->setText(QString("%1").arg(snapshot.aReg, 2, 16, QLatin1Char('0')).toUpper());
+    ui->lineEditBValue->setText(QString("%1").arg(snapshot.bReg, 2, 16, QLatin1Char('0')).toUpper());
+    ui->lineEditXValue->setText(QString("%1").arg(snapshot.xReg, 4, 16, QLatin1Char('0')).toUpper());
   } else {
-    ui->lineEditPCValue->setText(QString::number(PC));
-    ui->lineEditSPValue->setText(QString::number(SP));
-    ui->lineEditAValue->setText(QString::number(aReg));
-    ui->lineEditBValue->setText(QString::number(bReg));
-    ui->lineEditXValue->setText(QString::number(xReg));
+    ui->lineEditPCValue->setText(QString::number(snapshot.PC));
+    ui->lineEditSPValue->setText(QString::number(snapshot.SP));
+    ui->lineEditAValue->setText(QString::number(snapshot.aReg));
+    ui->lineEditBValue->setText(QString::number(snapshot.bReg));
+    ui->lineEditXValue->setText(QString::number(snapshot.xReg));
   }
-  if (useCycles) {
-    ui->labelRunningCycleNum->setText("Instruction cycle: " + QString::number(curCycle));
+  if (snapshot.useCycles) {
+    ui->labelRunningCycleNum->setText("Instruction cycle: " + QString::number(snapshot.curCycle));
   }
-  ui->lineEditTotalOpNum->setText(QString::number(opertaionsSinceStart));
+  ui->lineEditTotalOpNum->setText(QString::number(snapshot.operationsSinceStart));
   ui->lineEditTimeSinceStart->setText(QString::number((std::chrono::steady_clock::now() - processor->startTime).count() / 1000000000.0, 10, 3));
   if (ui->checkAutoScroll->isChecked()) {
-    int lineNum = assemblyMap.getObjectByAddress(PC).lineNumber;
+    int lineNum = assemblyMap.getObjectByAddress(snapshot.PC, snapshot.bank).lineNumber;
     if (lineNum >= 0) {
       if (lineNum > previousScrollCode + autoScrollUpLimit) {
         previousScrollCode = lineNum - autoScrollUpLimit;
-        ui->plainTextLines->verticalScrollBar()->setValue(previousScrollCode);
         ui->plainTextCode->verticalScrollBar()->setValue(previousScrollCode);
       } else if (lineNum < previousScrollCode + autoScrollDownLimit) {
         previousScrollCode = lineNum - autoScrollDownLimit;
-        ui->plainTextLines->verticalScrollBar()->setValue(previousScrollCode);
         ui->plainTextCode->verticalScrollBar()->setValue(previousScrollCode);
       }
     }
   }
   if (memoryDisplayMode == MemoryDisplayMode::FULL) {
-    int firstVisibleRow = ui->tableWidgetMemory->rowAt(0);
-    int lastVisibleRow = std::ceil(ui->tableWidgetMemory->rowAt(ui->tableWidgetMemory->viewport()->height() - 1));
-    for (int row = firstVisibleRow; row <= lastVisibleRow; ++row) {
-      for (int col = 0; col < ui->tableWidgetMemory->columnCount(); ++col) {
-        if (hexReg) {
-          ui->tableWidgetMemory->item(row, col)->setText(QString("%1").arg(memory[static_cast<uint16_t>(row * 16 + col)], 2, 16, QChar('0')).toUpper());
-        } else {
-          ui->tableWidgetMemory->item(row, col)->setText(QString("%1").arg(memory[static_cast<uint16_t>(row * 16 + col)]));
-        }
-      }
-    }
+    memoryModel->setMappedBank(snapshot.bank);
+    memoryModel->setMemory(snapshot.memory);
   } else if (memoryDisplayMode == MemoryDisplayMode::SIMPLE) {
     for (int i = 0; i < 20; ++i) {
       ui->tableWidgetSM->item(i, 0)->setText(QString("%1").arg(currentSMScroll + i, 4, 16, QChar('0')).toUpper());
 
-      ui->tableWidgetSM->item(i, 1)->setText(QString("%1").arg(memory[static_cast<uint16_t>(std::clamp(currentSMScroll + i, 0, 0xFFFF))], 2, 16, QChar('0').toUpper()));
+      ui->tableWidgetSM->item(i, 1)->setText(QString("%1").arg(snapshot.memory[static_cast<uint16_t>(std::clamp(currentSMScroll + i, 0, 0xFFFF))], 2, 16, QChar('0').toUpper()));
     }
+    drawSimpleMemoryInstructions(snapshot.memory, snapshot.bank);
   }
   if (displayStatusIndex == 1) {
-    ui->plainTextDisplay->setPlainText(getDisplayText(memory));
-    if (ui->plainTextDisplay->hasFocus()) {
-      processDisplayInputs(ui->plainTextDisplay);
+    ui->characterDisplay->setMemory(snapshot.memory);
+    if (ui->characterDisplay->hasFocus()) {
+      processDisplayInputs(ui->characterDisplay->cellAt(ui->characterDisplay->mapFromGlobal(QCursor::pos())));
     }
   } else if (displayStatusIndex == 2) {
-    plainTextDisplay->setPlainText(getDisplayText(memory));
-    if (plainTextDisplay->hasFocus()) {
-      processDisplayInputs(plainTextDisplay);
+    externalDisplay->setMemory(snapshot.memory);
+    if (externalDisplay->hasDisplayFocus()) {
+      processDisplayInputs(externalDisplay->pointerPosition());
     }
   }
-  setCurrentInstructionMarker(PC);
+  setCurrentInstructionMarker(snapshot.PC, snapshot.bank);
 }
 
 void MainWindow::onExecutionStopped() {
+  refreshTimer->stop();
   ui->buttonRunStop->setStyleSheet(redButton);
   drawProcessor();
   ui->labelRunningIndicatior->setVisible(false);
@@ -1055,7 +1045,7 @@ bool MainWindow::startAssembly() {
   PrintConsole("\nStarting assembly: Time: " + QTime::currentTime().toString("hh:mm:ss") + "\n");
   try {
     QString code = ui->plainTextCode->toPlainText();
-    assResult = Assembler::assemble(processorVersion, code, processor->Memory);
+    assResult = Assembler::assemble(processorVersion, code, processor->Memory, assemblyOptions);
   } catch (const std::exception &e) {
     PrintConsole("Critical error in assembler: " + QString(e.what()), MsgType::ERROR);
     ui->tabWidget->setCurrentIndex(0);
@@ -1085,20 +1075,187 @@ bool MainWindow::startAssembly() {
     return false;
   } else {
     assemblyMap = assResult.assemblyMap;
+    highlighter->setSymbols(assResult.symbols);
 
     std::memcpy(processor->backupMemory.data(), processor->Memory.data(), processor->Memory.size() * sizeof(uint8_t));
+    processor->banks.setInitialContents(assResult.banks);
     setAssemblyStatus(true);
     PrintConsole("\nAssembly Successful.");
     resetEmulator();
     return true;
   }
 }
+void MainWindow::printCycleAnalysis() {
+  if (!assembled && (writingMode != WritingMode::CODE || !startAssembly())) {
+    PrintConsole("Cycle analysis requires assembled code.", MsgType::ERROR);
+    ui->tabWidget->setCurrentIndex(0);
+    return;
+  }
+  PrintConsole("\nCycle analysis (base cycle counts, branches counted once):");
+  const FlowAnalyzer::ControlFlowGraph graph = FlowAnalyzer::buildGraph(processorVersion, assemblyMap);
+  foreach (Msg message, FlowAnalyzer::describeGraph(graph)) {
+    PrintConsole(message.message, message.type);
+  }
+  ui->tabWidget->setCurrentIndex(0);
+}
+void MainWindow::printInterruptTimingAnalysis() {
+  if (writingMode != WritingMode::CODE || (!assembled && !startAssembly())) {
+    PrintConsole("Interrupt timing analysis requires assembled code.", MsgType::ERROR);
+    ui->tabWidget->setCurrentIndex(0);
+    return;
+  }
+  PrintConsole("\nInterrupt timing analysis (worst case, loops limited by '; @bound N' annotations):");
+  const QStringList lines = ui->plainTextCode->toPlainText().split('\n');
+  const std::vector<TimingAnalyzer::HandlerBound> handlers = TimingAnalyzer::analyzeInterruptHandlers(processorVersion, assemblyMap, processor->backupMemory, lines);
+  foreach (Msg message, TimingAnalyzer::describeHandlers(handlers, latencyBudget)) {
+    PrintConsole(message.message, message.type);
+  }
+  ui->tabWidget->setCurrentIndex(0);
+}
+
+/**
+ * @brief Asks for the memory region and pixel format shown by the framebuffer display.
+ */
+void MainWindow::configureFramebuffer() {
+  FramebufferDisplay *framebuffer = externalDisplay->getFramebufferDisplay();
+  const FramebufferDisplay::Format &current = framebuffer->getFormat();
+
+  QDialog dialog(this);
+  dialog.setWindowTitle(tr("Framebuffer Settings"));
+  QFormLayout *layout = new QFormLayout(&dialog);
+
+  QSpinBox *address = new QSpinBox(&dialog);
+  address->setRange(0, 0xFFFF);
+  address->setDisplayIntegerBase(16);
+  address->setPrefix("$");
+  address->setValue(current.address);
+  layout->addRow(tr("Address:"), address);
+
+  QSpinBox *width = new QSpinBox(&dialog);
+  width->setRange(8, 256);
+  width->setSingleStep(8);
+  width->setValue(current.width);
+  layout->addRow(tr("Width:"), width);
+
+  QSpinBox *height = new QSpinBox(&dialog);
+  height->setRange(1, 256);
+  height->setValue(current.height);
+  layout->addRow(tr("Height:"), height);
+
+  QComboBox *depth = new QComboBox(&dialog);
+  depth->addItem(tr("1 bit per pixel"), 1);
+  depth->addItem(tr("2 bits per pixel"), 2);
+  depth->setCurrentIndex(current.bitsPerPixel - 1);
+  layout->addRow(tr("Depth:"), depth);
+
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+  connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+  layout->addRow(buttons);
+
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+  FramebufferDisplay::Format format;
+  format.address = static_cast<uint16_t>(address->value());
+  format.width = width->value();
+  format.height = height->value();
+  format.bitsPerPixel = depth->currentData().toInt();
+  if (!framebuffer->setFormat(format)) {
+    PrintConsole(QString("Framebuffer of %1x%2 pixels at %3 bit(s) per pixel does not fit in memory at $%4, or its width is not a whole number of bytes.")
+                     .arg(format.width)
+                     .arg(format.height)
+                     .arg(format.bitsPerPixel)
+                     .arg(QString("%1").arg(format.address, 4, 16, QChar('0')).toUpper()),
+                 MsgType::ERROR);
+    ui->tabWidget->setCurrentIndex(0);
+    return;
+  }
+  PrintConsole(QString("Framebuffer: $%1-$%2, %3x%4 pixels, %5 bit(s) per pixel")
+                   .arg(QString("%1").arg(format.address, 4, 16, QChar('0')).toUpper())
+                   .arg(QString("%1").arg(format.address + format.byteCount() - 1, 4, 16, QChar('0')).toUpper())
+                   .arg(format.width)
+                   .arg(format.height)
+                   .arg(format.bitsPerPixel));
+  externalDisplay->setMemory(processor->Memory);
+}
+
+/**
+ * @brief Lets the user set up banked memory, which takes effect for the next assembly.
+ *
+ * Execution is stopped first, the window keeps its contents as bank 0. The program has to be
+ * assembled again, the banks above bank 0 are cleared and the assembly map has the old layout.
+ */
+void MainWindow::configureMemoryBanks() {
+  const Core::BankLayout &current = processor->banks.layout();
+
+  QDialog dialog(this);
+  dialog.setWindowTitle(tr("Memory Banks"));
+  QFormLayout *layout = new QFormLayout(&dialog);
+
+  QSpinBox *bankCount = new QSpinBox(&dialog);
+  bankCount->setRange(0, 256);
+  bankCount->setSpecialValueText(tr("Off"));
+  bankCount->setValue(current.bankCount);
+  layout->addRow(tr("Banks:"), bankCount);
+
+  QComboBox *windowSize = new QComboBox(&dialog);
+  windowSize->addItem(tr("4K"), 0x1000);
+  windowSize->addItem(tr("8K"), 0x2000);
+  windowSize->addItem(tr("16K"), 0x4000);
+  windowSize->setCurrentIndex(windowSize->findData(current.windowSize));
+  layout->addRow(tr("Window size:"), windowSize);
+
+  QSpinBox *windowStart = new QSpinBox(&dialog);
+  windowStart->setRange(0, 0xFFFF);
+  windowStart->setDisplayIntegerBase(16);
+  windowStart->setPrefix("$");
+  windowStart->setValue(current.windowStart);
+  layout->addRow(tr("Window address:"), windowStart);
+
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+  connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+  layout->addRow(buttons);
+
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+  Core::BankLayout banks;
+  banks.bankCount = bankCount->value();
+  banks.windowSize = windowSize->currentData().toInt();
+  banks.windowStart = static_cast<uint16_t>(windowStart->value());
+  processor->stopExecution();
+  if (!processor->configureBanks(banks)) {
+    PrintConsole(QString("Memory banks: %1 banks need a window aligned to its size below $%2, at least 2 banks and a free bank select register at $%3.")
+                     .arg(banks.bankCount)
+                     .arg(QString::number(Core::deviceRegistersStart, 16).toUpper())
+                     .arg(QString::number(BankController::defaultAddress, 16).toUpper()),
+                 MsgType::ERROR);
+    ui->tabWidget->setCurrentIndex(0);
+    return;
+  }
+  assemblyOptions.banks = banks;
+  memoryModel->setBankLayout(banks);
+  setAssemblyStatus(false);
+  if (!banks.enabled()) {
+    PrintConsole("Memory banks: off\n", MsgType::DEBUG);
+    return;
+  }
+  PrintConsole(QString("Memory banks: %1 banks of %2K at $%3-$%4, selected through $%5\n")
+                   .arg(banks.bankCount)
+                   .arg(banks.windowSize / 1024)
+                   .arg(QString("%1").arg(banks.windowStart, 4, 16, QChar('0')).toUpper())
+                   .arg(QString("%1").arg(banks.windowStart + banks.windowSize - 1, 4, 16, QChar('0')).toUpper())
+                   .arg(QString::number(BankController::defaultAddress, 16).toUpper()),
+               MsgType::DEBUG);
+}
 bool MainWindow::startDisassembly() {
   processor->stopExecution();
   bool ORGOK;
   QString text = QInputDialog::getText(this,
                                        "Input Dialog",
-                                       "Enter the decimal address where the program beggins. Data before that will be written with .BYTE.",
+                                       "Enter an additional decimal address where code begins, or leave empty to trace from the reset and interrupt vectors only. Bytes not reached as code will be written with .BYTE.",
                                        QLineEdit::Normal,
                                        QString(),
                                        &ORGOK);
@@ -1106,14 +1263,18 @@ bool MainWindow::startDisassembly() {
     PrintConsole("Invalid address", MsgType::ERROR);
     return false;
   }
-  bool ORGNumOk;
-  uint16_t number = text.toUShort(&ORGNumOk);
-  if (!ORGNumOk) {
-    PrintConsole("Invalid address", MsgType::ERROR);
-    return false;
+  std::vector<uint16_t> entryPoints;
+  if (!text.trimmed().isEmpty()) {
+    bool ORGNumOk;
+    uint16_t number = text.toUShort(&ORGNumOk);
+    if (!ORGNumOk) {
+      PrintConsole("Invalid address", MsgType::ERROR);
+      return false;
+    }
+    entryPoints.push_back(number);
   }
 
-  DisassemblyResult disassResult = Disassembler::disassemble(processorVersion, number, 0xFFFF, processor->Memory);
+  DisassemblyResult disassResult = Disassembler::disassembleTraced(processorVersion, entryPoints, processor->Memory);
 
   ui->plainTextCode->setPlainText(disassResult.code);
   assemblyMap = disassResult.assemblyMap;
@@ -1128,6 +1289,6 @@ bool MainWindow::startDisassembly() {
 
 void MainWindow::SetMainDisplayVisibility(
   bool visible) {
-  ui->plainTextDisplay->setEnabled(visible);
-  ui->plainTextDisplay->setVisible(visible);
+  ui->characterDisplay->setEnabled(visible);
+  ui->characterDisplay->setVisible(visible);
 }
@@ -18,15 +18,25 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "src/assembler/DisassemblyCache.h"
 #include "src/core/Core.h"
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QPlainTextEdit>
 #include <QTableWidget>
 #include <QTreeWidgetItem>
 
+#include <memory>
+
 class Processor;
+class CodeHighlighter;
 class ExternalDisplay;
+class MemoryTableModel;
+class PerformanceDialog;
+class SerialConsole;
+class AutosaveWriter;
+class QTimer;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -49,12 +59,23 @@ private:
   // UI Components
   Ui::MainWindow *ui;
   ExternalDisplay *externalDisplay;
-  QPlainTextEdit *plainTextDisplay;
+  CodeHighlighter *highlighter;
+  MemoryTableModel *memoryModel;
+  PerformanceDialog *performanceDialog;
+  SerialConsole *serialConsole;
+  AutosaveWriter *autosaveWriter;
 
   // Core components
   Core::ProcessorVersion processorVersion = Core::ProcessorVersion::M6800;
   Processor *processor;
+  QTimer *refreshTimer;
+  std::unique_ptr<Core::ProcessorSnapshot> runningSnapshot;
+  QElapsedTimer frameClock; // time since the previous refresh while running
+  int droppedFrames = 0;    // frames lost since the last drawn one, to late refreshes or replaced snapshots
   Core::AssemblyMap assemblyMap;
+  Core::AssemblyOptions assemblyOptions;
+  DisassemblyCache disassemblyCache;
+  int latencyBudget = 0;
   QString sessionId;
 
   // UI Setup Methods
@@ -63,7 +84,6 @@ private:
   void setupSimpleMemory();
   void setupOPCTree();
   void setupIndicators();
-  void setupScrollbarConnections();
   void setupEventFilters();
   void setupCodeEditor();
   void setupProcessorConnections();
@@ -74,27 +94,31 @@ private:
   // Assembly and Memory Management
   bool startAssembly();
   bool startDisassembly();
+  void printCycleAnalysis();
+  void printInterruptTimingAnalysis();
+  void configureFramebuffer();
+  void configureMemoryBanks();
   void updateMemoryTab();
+  void drawProcessorRunning(const Core::ProcessorSnapshot &snapshot);
+  void drawSimpleMemoryInstructions(const std::array<uint8_t, 0x10000> &memory, int bank);
   void colorMemory(int address, Core::ColorType colorType);
-  void setCurrentInstructionMarker(int address);
+  void setCurrentInstructionMarker(int address, int bank);
   void setAssemblyErrorMarker(int charNum, int lineNum);
   int inputNextAddress(int curAdr, QString err);
 
   // Display and Drawing
   void drawOPC();
   void drawProcessor();
-  void processDisplayInputs(QPlainTextEdit *display);
-  QString getDisplayText(std::array<uint8_t, 0x10000> &memory);
+  void processDisplayInputs(const QPoint &position);
   void SetMainDisplayVisibility(bool visible);
 
   // Code Marker System
-  QVector<int> markedAddressList;
+  Core::AddressSet markedAddresses;
   void drawTextMarkers();
   void drawMemoryMarkers();
   void clearCodeMarkers();
   void clearMarkers();
   void toggleCodeMarker(int line);
-  void updateLinesBox(bool redraw);
 
   // File Operations
   void newFile();
@@ -104,6 +128,9 @@ private:
   void exit();
   void loadMemory();
   void saveMemory();
+  void exportDisassembly();
+  void insertDiskImage();
+  void ejectDiskImage();
 
   enum class WritingMode {
     MEMORY,
@@ -117,7 +144,7 @@ private:
   void setAllowWritingModeSwitch(bool allow);
   void setAssemblyStatus(bool isAssembled);
   void resetEmulator();
-  void showMemoryEditor(const QList<QTableWidgetItem *> &selectedItems, const QString &initialText = "", bool selectAll = false);
+  void showMemoryEditor(const QModelIndexList &selectedIndexes, const QString &initialText = "", bool selectAll = false);
 
   // State Variables
   bool errorDisplayed = false;
@@ -179,15 +206,9 @@ private:
 private slots:
 
   // Processor Event Handlers
-  void drawProcessorRunning(std::array<uint8_t, 0x10000>, int curCycle, uint8_t flags, uint16_t PC, uint16_t SP, uint8_t aReg, uint8_t bReg, uint16_t xReg, bool useCycles, uint64_t opertaionsSinceStart);
+  void refreshRunningView();
   void onExecutionStopped();
 
-  // Scroll Handlers
-  void handleCodeVerticalScrollBarValueChanged(int value);
-  void handleLinesScroll();
-  void handleDisplayScrollVertical();
-  void handleDisplayScrollHorizontal();
-
   // Button Bar Handlers
   bool on_buttonAssemble_clicked();
   void on_menuVersionSelector_currentIndexChanged(int index);
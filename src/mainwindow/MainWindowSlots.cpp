@@ -16,10 +16,12 @@
  */
 #include "src/dialogs/ExternalDisplay.h"
 #include "src/dialogs/InstructionInfoDialog.h"
+#include "src/dialogs/PerformanceDialog.h"
 #include "src/mainwindow/MainWindow.h"
+#include "src/mainwindow/MemoryTableModel.h"
 #include "src/processor/Processor.h"
 #include "ui_MainWindow.h"
-#include <QDir>
+#include <QScreen>
 #include <QScrollBar>
 #include <QTimer>
 
@@ -27,20 +29,6 @@ using Core::Action;
 using Core::ActionType;
 using Core::MemoryDisplayMode;
 using Core::ProcessorVersion;
-// Scroll Handlers
-void MainWindow::handleCodeVerticalScrollBarValueChanged(int value) {
-  ui->plainTextLines->verticalScrollBar()->setValue(value);
-}
-void MainWindow::handleLinesScroll() {
-  ui->plainTextLines->verticalScrollBar()->setValue(ui->plainTextCode->verticalScrollBar()->value());
-}
-void MainWindow::handleDisplayScrollVertical() {
-  // ui->plainTextDisplay->verticalScrollBar()->setValue(0);
-}
-void MainWindow::handleDisplayScrollHorizontal() {
-  // ui->plainTextDisplay->horizontalScrollBar()->setValue(0);
-}
-
 // Button bar Handlers
 bool MainWindow::on_buttonAssemble_clicked() {
   // ui->plainTextConsole->clear();
@@ -115,7 +103,15 @@ void MainWindow::on_buttonRunStop_clicked() {
         ui->labelRunningCycleNum->setVisible(true);
 
       ui->labelRunningIndicatior->setVisible(true);
-      processor->startExecution(executionNanoDelay, assemblyMap, markedAddressList);
+      processor->startExecution(executionNanoDelay, assemblyMap, markedAddresses);
+      // pull snapshots once per screen refresh, Qt widgets offer no vsync signal to follow
+      // headless and virtual screens can report no refresh rate, assume 60 Hz there
+      qreal refreshRate = screen()->refreshRate() > 0 ? screen()->refreshRate() : 60.0;
+      refreshTimer->start(std::max(1, qRound(1000.0 / refreshRate)));
+      processor->requestSnapshot();
+      performanceDialog->reset(1000000000.0 / executionNanoDelay);
+      droppedFrames = 0;
+      frameClock.start();
       ui->buttonRunStop->setStyleSheet(greenButton);
     }
   }
@@ -125,6 +121,7 @@ void MainWindow::on_menuSpeedSelector_activated() {
   executionNanoDelay = 1000000000 / OPS;
   ui->labelRunningIndicatior->setText("Operation/second: " + QString::number(OPS, 'f', OPS < 1 ? 1 : 0));
   processor->addAction(Action{ActionType::UPDATEPROCESSORSPEED, executionNanoDelay});
+  performanceDialog->setRequestedSpeed(1000000000.0 / executionNanoDelay);
 }
 
 void MainWindow::on_buttonSwitchWrite_clicked() {
@@ -161,15 +158,7 @@ void MainWindow::on_checkAssembleOnRun_clicked(bool checked) {
 }
 
 void MainWindow::on_checkAdvancedInfo_clicked(bool checked) {
-  if (checked) {
-    ui->plainTextLines->setGeometry(ui->plainTextLines->x(), ui->plainTextLines->y(), 181, ui->plainTextLines->height());
-    ui->plainTextLines->setMaximumWidth(181);
-  } else {
-    ui->plainTextLines->setGeometry(ui->plainTextLines->x(), ui->plainTextLines->y(), 101, ui->plainTextLines->height());
-    ui->plainTextLines->setMaximumWidth(101);
-  }
-
-  updateLinesBox(true);
+  ui->lineGutter->setAdvancedInfo(checked);
   drawTextMarkers();
 }
 
@@ -269,19 +258,19 @@ void MainWindow::on_menuDisplayStatus_currentIndexChanged(
     if (ui->menuDisplayStatus->count() == 3) {
       externalDisplay->hide();
       SetMainDisplayVisibility(true);
-      ui->plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+      ui->characterDisplay->setMemory(processor->Memory);
       displayStatusIndex = 1;
     } else {
       SetMainDisplayVisibility(false);
       externalDisplay->show();
       displayStatusIndex = 2;
-      plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+      externalDisplay->setMemory(processor->Memory);
     }
   } else {
     SetMainDisplayVisibility(false);
     externalDisplay->show();
     displayStatusIndex = 2;
-    plainTextDisplay->setPlainText(getDisplayText(processor->Memory));
+    externalDisplay->setMemory(processor->Memory);
   }
 }
 
@@ -445,13 +434,9 @@ void MainWindow::on_line2COMIN_valueChanged(
 
 // Memory Interaction Handlers
 void MainWindow::on_memoryAddressSpinBox_valueChanged(int arg1) {
-  int row = arg1 / 16;
-  QModelIndex index = ui->tableWidgetMemory->model()->index(row, 0);
-  ui->tableWidgetMemory->scrollTo(index, QAbstractItemView::PositionAtTop);
-
-  int column = arg1 % 16;
-  auto targetItem = ui->tableWidgetMemory->item(row, column);
-  ui->tableWidgetMemory->setCurrentItem(targetItem);
+  QModelIndex index = memoryModel->indexOf(arg1);
+  ui->tableViewMemory->scrollTo(index, QAbstractItemView::PositionAtTop);
+  ui->tableViewMemory->setCurrentIndex(index);
 }
 void MainWindow::on_simpleMemoryAddressSpinBox_valueChanged(int arg1) { // this spinBox should be capped to [0,0xFFFF]
   currentSMScroll = static_cast<uint16_t>(arg1);
@@ -466,40 +451,8 @@ void MainWindow::on_treeWidget_itemDoubleClicked(QTreeWidgetItem *item) {
   dialog.exec();
 }
 
-constexpr qsizetype CODE_MAX_LINE_COUNT = 100000;
 void MainWindow::on_plainTextCode_textChanged() {
-  static QTimer backupTimer;
-
-  // Limit line count
-  QString text = ui->plainTextCode->toPlainText();
-  if (text.count('\n') > CODE_MAX_LINE_COUNT) {
-    QStringList lines = text.split('\n', Qt::SkipEmptyParts);
-    text = lines.mid(0, CODE_MAX_LINE_COUNT + 1).join('\n');
-    ui->plainTextCode->setPlainText(text);
-  }
-
-  // Backup handling with debounce
-  if (!backupTimer.isActive()) {
-    backupTimer.setInterval(3000);
-    backupTimer.setSingleShot(true);
-    QPlainTextEdit *textEdit = ui->plainTextCode;
-    connect(&backupTimer, &QTimer::timeout, this, [textEdit, this]() {
-      QDir tempDir(QCoreApplication::applicationDirPath() + "/autosave");
-      if (!tempDir.exists()) {
-        tempDir.mkpath(".");
-      }
-      QString backupPath = tempDir.filePath("backup_session_" + sessionId + ".txt");
-      QFile backupFile(backupPath);
-      if (backupFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&backupFile);
-        out << textEdit->toPlainText();
-        backupFile.close();
-      }
-    });
-  }
-  backupTimer.start();
-
-  updateLinesBox(false);
+  // the autosave writer follows the document's contentsChange signal
   if (errorDisplayed) {
     clearCodeMarkers();
   }
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/mainwindow/MemoryTableModel.h"
+#include "src/core/Core.h"
+
+#include <cstring>
+
+namespace {
+  const QBrush headerBrush{QColor(210, 210, 255)};
+  const QBrush bankHeaderBrush{QColor(255, 225, 170)};
+  const QBrush defaultCellBrush{Core::memoryCellDefaultColor};
+} // namespace
+
+MemoryTableModel::MemoryTableModel(QObject *parent) : QAbstractTableModel(parent), cellFont("Lucida Console", 9, QFont::Bold) {
+}
+
+int MemoryTableModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : rows;
+}
+
+int MemoryTableModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : columns;
+}
+
+/**
+ * @brief Formats a memory cell when the view asks for it.
+ *
+ * Nothing is stored per cell apart from the byte itself, so only the cells being painted are
+ * formatted.
+ */
+QVariant MemoryTableModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid()) {
+    return QVariant();
+  }
+  int address = addressOf(index);
+  switch (role) {
+  case Qt::DisplayRole:
+    return hex ? QString("%1").arg(snapshot[address], 2, 16, QChar('0')).toUpper() : QString::number(snapshot[address]);
+  case Qt::BackgroundRole:
+    return cellBackgrounds.value(address, defaultCellBrush);
+  case Qt::ToolTipRole:
+    if (bankLayout.contains(address)) {
+      return QString("Bank %1, offset $%2").arg(mappedBank).arg(QString("%1").arg(address - bankLayout.windowStart, 4, 16, QChar('0')).toUpper());
+    }
+    return QVariant();
+  case Qt::TextAlignmentRole:
+    return QVariant(Qt::AlignCenter);
+  case Qt::FontRole:
+    return cellFont;
+  default:
+    return QVariant();
+  }
+}
+
+QVariant MemoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+  switch (role) {
+  case Qt::DisplayRole:
+    if (orientation == Qt::Horizontal) {
+      return QString::number(section, 16).toUpper();
+    }
+    return QString("%1").arg(section * columns, 4, 16, QChar('0')).toUpper();
+  case Qt::BackgroundRole:
+    return orientation == Qt::Vertical && bankLayout.contains(section * columns) ? bankHeaderBrush : headerBrush;
+  case Qt::ToolTipRole:
+    if (orientation == Qt::Vertical && bankLayout.contains(section * columns)) {
+      return QString("Bank window, bank %1 of %2 mapped").arg(mappedBank).arg(bankLayout.bankCount);
+    }
+    return QVariant();
+  case Qt::TextAlignmentRole:
+    return QVariant(Qt::AlignCenter);
+  case Qt::FontRole:
+    return cellFont;
+  default:
+    return QVariant();
+  }
+}
+
+Qt::ItemFlags MemoryTableModel::flags(const QModelIndex &index) const {
+  if (!index.isValid()) {
+    return Qt::NoItemFlags;
+  }
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+/**
+ * @brief Takes a new memory snapshot and notifies the view of the rows that changed.
+ *
+ * Consecutive changed rows are reported with a single dataChanged signal, unchanged rows are
+ * not reported at all.
+ */
+void MemoryTableModel::setMemory(const std::array<uint8_t, 0x10000> &memory) {
+  int firstDirtyRow = -1;
+  for (int row = 0; row <= rows; ++row) {
+    bool dirty = row < rows && std::memcmp(snapshot.data() + row * columns, memory.data() + row * columns, columns) != 0;
+    if (dirty && firstDirtyRow == -1) {
+      firstDirtyRow = row;
+    } else if (!dirty && firstDirtyRow != -1) {
+      std::memcpy(snapshot.data() + firstDirtyRow * columns, memory.data() + firstDirtyRow * columns, (row - firstDirtyRow) * columns);
+      emit dataChanged(index(firstDirtyRow, 0), index(row - 1, columns - 1), {Qt::DisplayRole});
+      firstDirtyRow = -1;
+    }
+  }
+}
+
+void MemoryTableModel::setHexadecimal(bool hexadecimal) {
+  if (hex == hexadecimal) {
+    return;
+  }
+  hex = hexadecimal;
+  emit dataChanged(index(0, 0), index(rows - 1, columns - 1), {Qt::DisplayRole});
+}
+
+void MemoryTableModel::setCellBackground(int address, const QBrush &brush) {
+  if (brush == defaultCellBrush) {
+    if (cellBackgrounds.remove(address) == 0) {
+      return;
+    }
+  } else {
+    cellBackgrounds.insert(address, brush);
+  }
+  QModelIndex cell = indexOf(address);
+  emit dataChanged(cell, cell, {Qt::BackgroundRole});
+}
+
+void MemoryTableModel::clearCellBackgrounds() {
+  const QList<int> addresses = cellBackgrounds.keys();
+  cellBackgrounds.clear();
+  for (int address : addresses) {
+    QModelIndex cell = indexOf(address);
+    emit dataChanged(cell, cell, {Qt::BackgroundRole});
+  }
+}
+
+/**
+ * @brief Marks the rows of the bank window, whose cells show the bank mapped in the last snapshot.
+ */
+void MemoryTableModel::setBankLayout(const Core::BankLayout &layout) {
+  bankLayout = layout;
+  mappedBank = 0;
+  emit headerDataChanged(Qt::Vertical, 0, rows - 1);
+}
+
+void MemoryTableModel::setMappedBank(int bank) {
+  if (bank == mappedBank || !bankLayout.enabled()) {
+    return;
+  }
+  mappedBank = bank;
+  emit headerDataChanged(Qt::Vertical, bankLayout.windowStart / columns, (bankLayout.windowStart + bankLayout.windowSize) / columns - 1);
+}
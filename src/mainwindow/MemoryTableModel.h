@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MEMORYTABLEMODEL_H
+#define MEMORYTABLEMODEL_H
+
+#include "src/core/Core.h"
+
+#include <QAbstractTableModel>
+#include <QBrush>
+#include <QFont>
+#include <QHash>
+
+#include <array>
+#include <stdint.h>
+
+class MemoryTableModel final : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  static constexpr int columns = 16;
+  static constexpr int rows = 0x10000 / columns;
+
+  explicit MemoryTableModel(QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+  Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+  static int addressOf(const QModelIndex &index) { return index.row() * columns + index.column(); }
+  QModelIndex indexOf(int address) const { return index(address / columns, address % columns); }
+
+  void setMemory(const std::array<uint8_t, 0x10000> &memory);
+  void setHexadecimal(bool hexadecimal);
+  void setCellBackground(int address, const QBrush &brush);
+  void clearCellBackgrounds();
+  void setBankLayout(const Core::BankLayout &layout);
+  void setMappedBank(int bank);
+  int displayedBank() const { return mappedBank; }
+
+private:
+  std::array<uint8_t, 0x10000> snapshot{};
+  Core::BankLayout bankLayout;
+  int mappedBank = 0;
+  QHash<int, QBrush> cellBackgrounds; // only cells which differ from the default color
+  bool hex = true;
+  QFont cellFont;
+};
+
+#endif // MEMORYTABLEMODEL_H
@@ -16,6 +16,7 @@
  */
 #include "src/processor/Processor.h"
 #include "src/utils/ActionQueue.h"
+#include <QSet>
 #include <QtConcurrent/QtConcurrent>
 using Core::Action;
 using Core::ActionType;
@@ -24,9 +25,13 @@ using Core::Flag;
 using Core::Interrupt;
 using Core::ProcessorVersion;
 
-Processor::Processor(ProcessorVersion version) {
+Processor::Processor(ProcessorVersion version) : workerSnapshot(std::make_unique<Core::ProcessorSnapshot>()), readySnapshot(std::make_unique<Core::ProcessorSnapshot>()) {
   actionQueueWhenReady = new ActionQueue();
   actionQueueBeforeInstruction = new ActionQueue();
+  keyboard.attachTo(deviceBus);
+  pointer.attachTo(deviceBus);
+  serial.attachTo(deviceBus, Acia6850::defaultAddress);
+  storage.attachTo(deviceBus);
   switchVersion(version);
 }
 
@@ -51,6 +56,36 @@ void Processor::switchVersion(ProcessorVersion version) {
   case Core::ALL:
     throw std::invalid_argument("");
   }
+  buildOperandAccess();
+}
+
+/**
+ * @brief Classifies how every opcode of the current version accesses its memory operand.
+ *
+ * Only extended and indexed operands can reach the device registers, direct ones stay in the
+ * first page. Jumps do not access their operand. Stores and CLR only write, the shifts, rotates,
+ * INC, DEC, COM and NEG read and write, everything else only reads.
+ */
+void Processor::buildOperandAccess() {
+  static const QSet<QString> wordOperands = {"LDD", "LDS", "LDX", "STD", "STS", "STX", "CPX", "ADDD", "SUBD"};
+  static const QSet<QString> writeOnly = {"STAA", "STAB", "STD", "STS", "STX", "CLR"};
+  static const QSet<QString> readModifyWrite = {"NEG", "COM", "LSR", "ROR", "ASR", "ASL", "ROL", "DEC", "INC"};
+  for (int opCode = 0; opCode < 256; ++opCode) {
+    OperandAccess &access = operandAccess[opCode];
+    access = OperandAccess();
+    Core::AddressingMode mode = getInstructionMode(processorVersion, opCode);
+    if (mode != Core::AddressingMode::EXT && mode != Core::AddressingMode::IND) {
+      continue;
+    }
+    QString mnemonic = Core::getInfoByOpCode(processorVersion, opCode).mnemonic;
+    if (mnemonic == "JMP" || mnemonic == "JSR") {
+      continue;
+    }
+    access.width = wordOperands.contains(mnemonic) ? 2 : 1;
+    access.indexed = mode == Core::AddressingMode::IND;
+    access.read = !writeOnly.contains(mnemonic);
+    access.write = writeOnly.contains(mnemonic) || readModifyWrite.contains(mnemonic);
+  }
 }
 
 /**
@@ -76,7 +111,8 @@ void Processor::addAction(const Action &action) {
  * @brief Processes all pending actions from the action queue.
  *
  * Iteratively retrieves and handles each action in the queue until
- * no actions remain.
+ * no actions remain. Together with the instruction timed actions the
+ * pointer device is sampled, once per batch while running.
  */
 void Processor::handleActions(Core::ActionExecutionTiming timing) {
   while (actionQueueWhenReady->hasActions()) {
@@ -89,10 +125,25 @@ void Processor::handleActions(Core::ActionExecutionTiming timing) {
       Action action = actionQueueBeforeInstruction->getNextAction();
       handleAction(action);
     }
+    pointer.sample();
   }
 }
 
-QVector<int> newBookmarkedAddresses;
+Core::AddressSet newBookmarkedAddresses;
+
+/**
+ * @brief Sets up banked memory, must only be called while execution is stopped.
+ *
+ * @param layout The bank window and the number of banks, no banks turns banking off.
+ * @return False if the layout is invalid or its bank select register is taken by another device.
+ */
+bool Processor::configureBanks(const Core::BankLayout &layout) {
+  if (!layout.isValid() || (layout.enabled() && !deviceBus.isFree(BankController::defaultAddress, BankController::registerCount, &banks))) {
+    return false;
+  }
+  banks.configure(deviceBus, layout);
+  return true;
+}
 
 /**
  * @brief Stages bookmark data for the next update cycle.
@@ -100,9 +151,9 @@ QVector<int> newBookmarkedAddresses;
  * Stores the provided bookmark addresses temporarily. The data is applied
  * to the active bookmarked addresses when an UPDATEBOOKMARKS action is processed.
  *
- * @param data Vector of memory addresses to be bookmarked.
+ * @param data Set of memory addresses to be bookmarked.
  */
-void Processor::queueBookmarkData(QVector<int> data){
+void Processor::queueBookmarkData(const Core::AddressSet &data){
     newBookmarkedAddresses = data;
 }
 
@@ -112,7 +163,7 @@ struct MemUpdateData {
 };
 
 QList<MemUpdateData> memUpdateList;
-void Processor::setMemoryUpdate(QVector<uint16_t> addresses, uint8_t value) {
+void Processor::setMemoryUpdate(const QVector<uint16_t> &addresses, uint8_t value) {
   memUpdateList.append({addresses, value});
 }
 
@@ -166,20 +217,24 @@ void Processor::handleAction(const Action &action) {
     memUpdateList.clear();
     break;
   case ActionType::SETKEY:
-    Memory[0xFFF0] = action.parameter & 0xFF;
+    keyboard.pressKey(action.parameter & 0xFF);
     if (IRQOnKeyPressed || WAIStatus) {
       if (pendingInterrupt == Interrupt::NONE)
         pendingInterrupt = Interrupt::IRQ;
     }
     break;
-  case ActionType::SETMOUSECLICK:
-    Memory[0xFFF1] = action.parameter & 0xFF;
+
+  case ActionType::SETSERIALADDRESS:
+    if (deviceBus.isFree(action.parameter & 0xFFFF, Acia6850::registerCount, &serial)) {
+      serial.attachTo(deviceBus, action.parameter & 0xFFFF);
+    }
     break;
-  case ActionType::SETMOUSEX:
+  case ActionType::SETSERIALBAUD:
+    serial.setBaudRate(action.parameter);
     break;
-  case ActionType::SETMOUSEY:
+  case ActionType::SETBLOCKIMAGE:
+    storage.loadInserted();
     break;
-
   case ActionType::SETIRQONKEYPRESS:
     IRQOnKeyPressed = action.parameter;
     break;
@@ -208,7 +263,7 @@ void Processor::checkBreak() {
   case 0:
     break;
   case 1:
-    if (assemblyMap.getObjectByAddress(PC).lineNumber == breakIsValue)
+    if (assemblyMap.getObjectByAddress(PC, banks.selectedBank()).lineNumber == breakIsValue)
       running = false;
     break;
   case 2:
@@ -261,7 +316,7 @@ void Processor::checkBreak() {
     break;
   }
   if(bookmarkBreakpointsEnabled)  {
-    if(bookmarkedAddresses.contains(PC)){
+    if(bookmarkedAddresses.test(PC)){
       running = false;
     }
   }
@@ -317,16 +372,65 @@ inline uint16_t Processor::getInterruptLocation(Interrupt interrupt) {
 }
 
 /**
- * @brief Captures the current processor state and emits it to the UI layer.
+ * @brief Captures the current processor state if the UI asked for it since the last capture.
  *
- * Creates a complete copy of the processor's memory and packages it with
- * register values, flags, cycle counters, and operation count. This data
- * is transmitted via the uiUpdateData signal for display purposes.
+ * The state is written into a buffer owned by the worker and then swapped with the ready
+ * buffer, so the lock is held only for a pointer swap. A snapshot the UI has not taken yet is
+ * replaced, stale frames are dropped rather than queued.
  */
-void Processor::setUIUpdateData() {
-  std::array<uint8_t, 0x10000> memoryCopy;
-  std::copy(Memory.begin(), Memory.end(), memoryCopy.begin());
-  emit uiUpdateData(memoryCopy, curCycle, flags, PC, SP, aReg, bReg, xReg, useCycles, operationsSinceStart);
+void Processor::publishSnapshot() {
+  if (!snapshotRequested.exchange(false, std::memory_order_acquire)) {
+    return;
+  }
+  auto copyStart = std::chrono::steady_clock::now();
+  workerSnapshot->memory = Memory;
+  workerSnapshot->bank = banks.selectedBank();
+  workerSnapshot->curCycle = curCycle;
+  workerSnapshot->flags = flags;
+  workerSnapshot->PC = PC;
+  workerSnapshot->SP = SP;
+  workerSnapshot->aReg = aReg;
+  workerSnapshot->bReg = bReg;
+  workerSnapshot->xReg = xReg;
+  workerSnapshot->useCycles = useCycles;
+  workerSnapshot->operationsSinceStart = operationsSinceStart;
+  auto copyEnd = std::chrono::steady_clock::now();
+  workerSnapshot->performance = Core::PerformanceSample{instructionsSinceStart,
+                                                       cyclesSinceStart,
+                                                       busyTime.count(),
+                                                       std::chrono::duration_cast<std::chrono::nanoseconds>(copyEnd.time_since_epoch()).count(),
+                                                       std::chrono::duration_cast<std::chrono::nanoseconds>(copyEnd - copyStart).count(),
+                                                       static_cast<int>(actionQueueWhenReady->size() + actionQueueBeforeInstruction->size())};
+
+  QMutexLocker locker(&snapshotMutex);
+  workerSnapshot->replacedSnapshots = snapshotReady ? readySnapshot->replacedSnapshots + 1 : 0;
+  std::swap(workerSnapshot, readySnapshot);
+  snapshotReady = true;
+}
+
+/**
+ * @brief Asks the execution thread to capture its state at the end of the current batch.
+ */
+void Processor::requestSnapshot() {
+  snapshotRequested.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Takes the latest captured state, if there is one the caller has not seen yet.
+ *
+ * The caller's buffer is swapped with the ready one, so no memory is copied.
+ *
+ * @param snapshot Buffer owned by the caller, replaced by the latest snapshot.
+ * @return Whether a new snapshot was taken.
+ */
+bool Processor::takeSnapshot(std::unique_ptr<Core::ProcessorSnapshot> &snapshot) {
+  QMutexLocker locker(&snapshotMutex);
+  if (!snapshotReady) {
+    return false;
+  }
+  std::swap(snapshot, readySnapshot);
+  snapshotReady = false;
+  return true;
 }
 
 /**
@@ -336,7 +440,12 @@ void Processor::setUIUpdateData() {
  * table based on the opcode at the current program counter.
  */
 void Processor::executeM6800() {
-  (this->*M6800Table[Memory[PC]])();
+  uint8_t opCode = Memory[PC];
+  if (operandAccess[opCode].width == 0) {
+    (this->*M6800Table[opCode])();
+  } else {
+    executeWithDeviceAccess(M6800Table[opCode], operandAccess[opCode]);
+  }
 }
 
 /**
@@ -346,7 +455,38 @@ void Processor::executeM6800() {
  * table based on the opcode at the current program counter.
  */
 void Processor::executeM6803() {
-  (this->*M6803Table[Memory[PC]])();
+  uint8_t opCode = Memory[PC];
+  if (operandAccess[opCode].width == 0) {
+    (this->*M6803Table[opCode])();
+  } else {
+    executeWithDeviceAccess(M6803Table[opCode], operandAccess[opCode]);
+  }
+}
+
+/**
+ * @brief Executes an instruction with an extended or indexed operand and reports its access to the devices.
+ *
+ * The operand address is taken before execution, since the instruction may change the index
+ * register. Accesses outside the device register window cost only the address comparison.
+ */
+void Processor::executeWithDeviceAccess(funcPtr instruction, const OperandAccess &access) {
+  uint16_t address = access.indexed ? (*curIndReg + Memory[(PC + 1) & 0xFFFF]) & 0xFFFF : (Memory[(PC + 1) & 0xFFFF] << 8) | Memory[(PC + 2) & 0xFFFF];
+  (this->*instruction)();
+  if (address + access.width > Core::deviceRegistersStart && address < Core::deviceRegistersEnd) {
+    deviceBus.access(address, access.width, access.read, access.write);
+  }
+}
+
+/**
+ * @brief Raises an IRQ at an instruction boundary while a device holds its interrupt line.
+ *
+ * Device interrupts are level triggered, an IRQ ignored because of the interrupt mask is raised
+ * again once the mask is cleared, as long as the device still requests it.
+ */
+void Processor::pollDeviceInterrupt() {
+  if (deviceBus.interruptAsserted() && pendingInterrupt == Interrupt::NONE && !bit(flags, Flag::InterruptMask)) {
+    pendingInterrupt = Interrupt::IRQ;
+  }
 }
 
 /**
@@ -499,7 +639,11 @@ void Processor::interruptCheckIPS() {
  * debugging or simplified timing simulation.
  */
 void Processor::executeStep() {
+  int cycles = getInstructionCycleCount(processorVersion, Memory[PC]);
+  pointer.sample();
+  pollDeviceInterrupt();
   interruptCheckIPS();
+  deviceBus.tick(cycles);
 }
 
 
@@ -507,9 +651,8 @@ void Processor::updateSpeedParams(uint32_t newNanoDelay){
 
   double OPS = 1000000000 / newNanoDelay;
   nanoDelay = newNanoDelay;
-  uiUpdateSpeed = 250;
-  if (OPS > uiUpdateSpeed) {
-    batchSize = OPS / uiUpdateSpeed;
+  if (OPS > batchesPerSecond) {
+    batchSize = OPS / batchesPerSecond;
   } else {
     batchSize = 1;
   }
@@ -521,9 +664,9 @@ void Processor::updateSpeedParams(uint32_t newNanoDelay){
  *
  * Configures execution parameters based on the specified operations per second,
  * initializes timing and cycle counters, and launches a concurrent execution loop.
- * The loop processes instructions in batches to balance execution speed with UI
- * responsiveness, updating the interface at approximately 250 Hz regardless of
- * the execution rate.
+ * The loop processes instructions in batches of about 4 ms. At the end of a batch the
+ * state is captured if the UI has requested a snapshot, the UI pulls snapshots at its own
+ * refresh rate and never slows the loop down.
  *
  * Execution continues until halted by a breakpoint condition or external stop request.
  * Actions are processed both at loop entry and between instruction batches.
@@ -532,15 +675,20 @@ void Processor::updateSpeedParams(uint32_t newNanoDelay){
  * @param list Assembly source mapping for line-number-based breakpoints.
  * @param bookmarkedAddresses Memory addresses configured as breakpoints.
  */
-void Processor::startExecution(uint32_t nanoSecondDelay, AssemblyMap list, QVector<int> bookmarkedAddressesVector) {
+void Processor::startExecution(uint32_t nanoSecondDelay, AssemblyMap list, const Core::AddressSet &bookmarkedAddressesSet) {
   assemblyMap = list;
-  this->bookmarkedAddresses = bookmarkedAddressesVector;
+  this->bookmarkedAddresses = bookmarkedAddressesSet;
   running = true;
   curCycle = 1;
   cycleCount = getInstructionCycleCount(processorVersion, Memory[PC]);
   operationsSinceStart = 0;
+  instructionsSinceStart = 0;
+  cyclesSinceStart = 0;
+  busyTime = std::chrono::nanoseconds(0);
 
   updateSpeedParams(nanoSecondDelay);
+  snapshotRequested = false;
+  snapshotReady = false;
 
   startTime = std::chrono::steady_clock::now();
   futureWatcher.setFuture(QtConcurrent::run([this]() {
@@ -555,35 +703,46 @@ void Processor::startExecution(uint32_t nanoSecondDelay, AssemblyMap list, QVect
 
       handleActions(Core::ActionExecutionTiming::BEFORE_INSTRUCTION);
       next = next + std::chrono::nanoseconds(nanoDelay * batchSize);
+      auto batchStart = std::chrono::steady_clock::now();
       for (int i = 0; i < batchSize; i++) {
         if (!running) {
           break;
         }
         if (useCycles) {
+          cyclesSinceStart++;
+          deviceBus.tick(1);
           if (curCycle < cycleCount) {
             curCycle++;
             operationsSinceStart++;
             if (i + 1 == batchSize) {
-              setUIUpdateData();
+              publishSnapshot();
             }
           } else {
+            pollDeviceInterrupt();
             interruptCheckCPS();
             checkBreak();
             curCycle = 1;
             operationsSinceStart++;
+            instructionsSinceStart++;
             if (i + 1 == batchSize) {
-              setUIUpdateData();
+              publishSnapshot();
             }
           }
         } else {
+          int cycles = getInstructionCycleCount(processorVersion, Memory[PC]);
+          cyclesSinceStart += cycles;
+          pollDeviceInterrupt();
           interruptCheckIPS();
+          deviceBus.tick(cycles);
           checkBreak();
           operationsSinceStart++;
+          instructionsSinceStart++;
           if (i + 1 == batchSize) {
-            setUIUpdateData();
+            publishSnapshot();
           }
         }
       }
+      busyTime += std::chrono::steady_clock::now() - batchStart;
     }
     handleActions(Core::ActionExecutionTiming::WHEN_NOT_RUNNING);
     emit executionStopped();
@@ -616,6 +775,7 @@ void Processor::reset() {
   stopExecution();
 
   std::copy(backupMemory.begin(), backupMemory.end(), Memory.begin());
+  deviceBus.reset();
 
   WAIStatus = false;
   pendingInterrupt = Interrupt::NONE;
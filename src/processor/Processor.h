@@ -18,8 +18,18 @@
 #define PROCESSOR_H
 
 #include "src/core/Core.h"
+#include "src/devices/Acia6850.h"
+#include "src/devices/BankController.h"
+#include "src/devices/BlockDevice.h"
+#include "src/devices/DeviceBus.h"
+#include "src/devices/KeyboardController.h"
+#include "src/devices/PointerDevice.h"
 
 #include <QFutureWatcher>
+#include <QMutex>
+
+#include <atomic>
+#include <memory>
 
 class ActionQueue;
 
@@ -27,13 +37,25 @@ class Processor : public QObject {
   Q_OBJECT
 private:
   typedef void (Processor::*funcPtr)();
+  // how an instruction accesses the memory operand, looked up per opcode to find device register accesses
+  struct OperandAccess {
+    uint8_t width = 0; // 0 when the instruction can not reach the device registers
+    bool indexed = false;
+    bool read = false;
+    bool write = false;
+  };
   ActionQueue *actionQueueWhenReady;
   ActionQueue *actionQueueBeforeInstruction;
   Core::AssemblyMap assemblyMap;
 
-  QVector<int> bookmarkedAddresses;
+  Core::AddressSet bookmarkedAddresses;
   QFutureWatcher<void> futureWatcher;
   funcPtr executeInstruction;
+  std::array<OperandAccess, 256> operandAccess;
+
+  // peripherals, their registers are part of Memory
+  DeviceBus deviceBus;
+  KeyboardController keyboard{Memory};
   Core::ProcessorVersion processorVersion = Core::ProcessorVersion::M6800;
 
   //internal settings
@@ -45,15 +67,26 @@ private:
   uint16_t breakAtValue = 0;
   bool bookmarkBreakpointsEnabled = false;
 
+  static constexpr int batchesPerSecond = 250;
   int nanoDelay = 0;
-  int uiUpdateSpeed = 250;
   int batchSize = 0;
 
+  // snapshots handed to the UI, the worker fills its own buffer and swaps it in under the lock
+  std::atomic<bool> snapshotRequested = false;
+  QMutex snapshotMutex;
+  std::unique_ptr<Core::ProcessorSnapshot> workerSnapshot;
+  std::unique_ptr<Core::ProcessorSnapshot> readySnapshot;
+  bool snapshotReady = false;
+
 public:
   explicit Processor(Core::ProcessorVersion version);
   //processor internals
   std::array<uint8_t, 0x10000> Memory = {};
   std::array<uint8_t, 0x10000> backupMemory = {};
+  PointerDevice pointer{Memory}; // fed by the UI thread, sampled by the execution thread
+  Acia6850 serial{Memory};       // its line is served by a host side thread or the UI
+  BlockDevice storage{Memory};   // images are inserted by the UI thread, see SETBLOCKIMAGE
+  BankController banks{Memory};  // configured while stopped, through configureBanks
   uint8_t aReg = 0;
   uint8_t bReg = 0;
   uint16_t PC = 0;
@@ -65,6 +98,9 @@ public:
   int cycleCount = 0;
   Core::Interrupt pendingInterrupt = Core::Interrupt::NONE;
   uint64_t operationsSinceStart = 0;
+  uint64_t instructionsSinceStart = 0;
+  uint64_t cyclesSinceStart = 0;
+  std::chrono::nanoseconds busyTime{0}; // time spent executing batches since the start
   //runtime settings
   volatile bool running = false;
   bool useCycles = false;
@@ -74,14 +110,19 @@ public:
   void switchVersion(Core::ProcessorVersion version);
   void addAction(const Core::Action &action);
 
-  void queueBookmarkData(const QVector<int> &data);
+  bool isDeviceAddressFree(uint16_t address, int registerCount, const IODevice &device) const { return deviceBus.isFree(address, registerCount, &device); }
+  bool configureBanks(const Core::BankLayout &layout);
+  void queueBookmarkData(const Core::AddressSet &data);
   void setMemoryUpdate(const QVector<uint16_t> &addresses, uint8_t value);
 
   void reset();
   void executeStep();
-  void startExecution(uint32_t nanoSecondDelay, Core::AssemblyMap list, QVector<int> bookmarkedAddresses);
+  void startExecution(uint32_t nanoSecondDelay, Core::AssemblyMap list, const Core::AddressSet &bookmarkedAddresses);
   void stopExecution();
 
+  void requestSnapshot();
+  bool takeSnapshot(std::unique_ptr<Core::ProcessorSnapshot> &snapshot);
+
 private:
   //action handling
   void handleAction(const Core::Action &action);
@@ -94,17 +135,19 @@ private:
   uint16_t getInterruptLocation(Core::Interrupt interrupt);
 
   //instructionExecution
-  void setUIUpdateData();
+  void publishSnapshot();
 
+  void buildOperandAccess();
   void executeM6800();
   void executeM6803();
+  void executeWithDeviceAccess(funcPtr instruction, const OperandAccess &access);
+  void pollDeviceInterrupt();
 
   void interruptCheckCPS();
   void interruptCheckIPS();
 
   void updateSpeedParams(uint32_t newNanoDelay);
 signals:
-  void uiUpdateData(std::array<uint8_t, 0x10000> memoryCopy, int curCycle, uint8_t flags, uint16_t PC, uint16_t SP, uint8_t aReg, uint8_t bReg, uint16_t xReg, bool useCycles, uint64_t opertaionsSinceStart);
   void executionStopped();
 
 private:
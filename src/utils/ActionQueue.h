@@ -37,6 +37,10 @@ public:
     std::lock_guard<std::mutex> lock(mutex_);
     return !queue_.empty();
   }
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
   Core::Action getNextAction() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (queue_.empty()) {
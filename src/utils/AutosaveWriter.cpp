@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/utils/AutosaveWriter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+  constexpr int flushDelay = 3000;                // ms, edits are collected before they are written
+  constexpr qint64 minCompactionSize = 64 * 1024; // journals smaller than this are never compacted
+
+  /**
+   * @brief Applies one edit to a text, returns false if the edit leaves the text unchanged.
+   *
+   * Counts are clamped to the text, the document sometimes reports one character past its end.
+   */
+  bool applyToText(QString &text, qsizetype position, qsizetype charsRemoved, const QString &inserted) {
+    position = std::clamp<qsizetype>(position, 0, text.size());
+    charsRemoved = std::clamp<qsizetype>(charsRemoved, 0, text.size() - position);
+    if (charsRemoved == inserted.size() && QStringView(text).sliced(position, charsRemoved) == inserted) {
+      return false;
+    }
+    text.replace(position, charsRemoved, inserted);
+    return true;
+  }
+} // namespace
+
+/**
+ * @brief Owns the copy of the text and the files, runs entirely on the writer thread.
+ */
+class AutosaveWriter::Worker final : public QObject {
+public:
+  Worker(const QString &directoryPath, const QString &sessionName, const QString &initialText)
+      : directory(directoryPath), name(sessionName), snapshotPath(QDir(directoryPath).filePath(sessionName + ".txt")), journalPath(QDir(directoryPath).filePath(sessionName + ".journal")),
+        text(initialText), lock(QDir(directoryPath).filePath(sessionName + ".lock")) {}
+
+  void start();
+  void applyEdit(int position, int charsRemoved, const QString &inserted);
+  void flush();
+  void finish();
+
+private:
+  QString directory;
+  QString name;
+  QString snapshotPath;
+  QString journalPath;
+  QString text;                  // the document as of the last recorded edit
+  qsizetype snapshotLength = -1; // length of the text in the snapshot file, -1 before the first compaction
+  QByteArray pending;            // records not yet appended to the journal
+  qint64 journalSize = 0;
+  QTimer *flushTimer = nullptr;
+  QLockFile lock;
+
+  bool compact();
+  static void replayJournal(const QString &snapshotFilePath, const QString &journalFilePath);
+};
+
+/**
+ * @brief Locks the session and replays the journals other sessions left behind.
+ *
+ * A lock whose process no longer runs is taken over, so only sessions still open are skipped.
+ */
+void AutosaveWriter::Worker::start() {
+  QDir dir(directory);
+  dir.mkpath(".");
+  lock.setStaleLockTime(0);
+  lock.tryLock(0);
+  for (const QString &journal : dir.entryList({"*.journal"}, QDir::Files)) {
+    QString other = journal.chopped(QString(".journal").size());
+    if (other == name) {
+      continue;
+    }
+    QLockFile otherLock(dir.filePath(other + ".lock"));
+    otherLock.setStaleLockTime(0);
+    if (otherLock.tryLock(0)) {
+      replayJournal(dir.filePath(other + ".txt"), dir.filePath(journal));
+    }
+  }
+}
+
+/**
+ * @brief Applies the records of a journal to its snapshot and removes the journal.
+ *
+ * A journal whose base length does not match the snapshot is stale and only removed. A record
+ * cut off by a crash ends the replay, the records before it are kept.
+ */
+void AutosaveWriter::Worker::replayJournal(const QString &snapshotFilePath, const QString &journalFilePath) {
+  QFile journalFile(journalFilePath);
+  if (!journalFile.open(QIODevice::ReadOnly)) {
+    return;
+  }
+  QByteArray journal = journalFile.readAll();
+  journalFile.close();
+
+  QString snapshotText;
+  QFile snapshotFile(snapshotFilePath);
+  if (snapshotFile.open(QIODevice::ReadOnly)) {
+    snapshotText = QString::fromUtf8(snapshotFile.readAll());
+    snapshotFile.close();
+  }
+
+  qsizetype position = journal.indexOf('\n') + 1;
+  if (!journal.startsWith("#base ") || position == 0 || journal.mid(6, position - 7).toLongLong() != snapshotText.size()) {
+    QFile::remove(journalFilePath);
+    return;
+  }
+  while (position < journal.size() && journal[position] == '@') {
+    qsizetype headerEnd = journal.indexOf('\n', position);
+    if (headerEnd == -1) {
+      break;
+    }
+    QList<QByteArray> fields = journal.mid(position + 1, headerEnd - position - 1).split(',');
+    if (fields.size() != 3) {
+      break;
+    }
+    qsizetype bytes = fields[2].toLongLong();
+    if (headerEnd + bytes + 2 > journal.size()) {
+      break;
+    }
+    applyToText(snapshotText, fields[0].toLongLong(), fields[1].toLongLong(), QString::fromUtf8(journal.mid(headerEnd + 1, bytes)));
+    position = headerEnd + bytes + 2;
+  }
+
+  QSaveFile snapshot(snapshotFilePath);
+  if (snapshot.open(QIODevice::WriteOnly)) {
+    snapshot.write(snapshotText.toUtf8());
+    if (snapshot.commit()) {
+      QFile::remove(journalFilePath);
+    }
+  }
+}
+
+/**
+ * @brief Applies an edit to the copy of the text and queues its journal record.
+ *
+ * Edits which leave the text unchanged, such as reformatting, are dropped.
+ */
+void AutosaveWriter::Worker::applyEdit(int position, int charsRemoved, const QString &inserted) {
+  position = std::clamp<qsizetype>(position, 0, text.size());
+  charsRemoved = std::clamp<qsizetype>(charsRemoved, 0, text.size() - position);
+  if (!applyToText(text, position, charsRemoved, inserted)) {
+    return;
+  }
+
+  QByteArray bytes = inserted.toUtf8();
+  pending += QString("@%1,%2,%3\n").arg(position).arg(charsRemoved).arg(bytes.size()).toUtf8();
+  pending += bytes;
+  pending += '\n';
+
+  if (flushTimer == nullptr) {
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(flushDelay);
+    connect(flushTimer, &QTimer::timeout, this, &Worker::flush);
+  }
+  if (!flushTimer->isActive()) {
+    flushTimer->start();
+  }
+}
+
+/**
+ * @brief Appends the queued records to the journal, compacting it once it outgrows the text.
+ *
+ * Compaction rewrites the whole text, doing it only when the journal is larger than the text
+ * keeps the cost per edited character constant.
+ */
+void AutosaveWriter::Worker::flush() {
+  if (flushTimer != nullptr) {
+    flushTimer->stop();
+  }
+  if (pending.isEmpty()) {
+    return;
+  }
+  QDir().mkpath(directory);
+  if (snapshotLength == -1 || journalSize + pending.size() > std::max<qint64>(minCompactionSize, text.size())) {
+    compact();
+    return;
+  }
+  QFile journal(journalPath);
+  if (journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    journalSize += journal.write(pending);
+    pending.clear();
+  }
+}
+
+/**
+ * @brief Brings the snapshot up to date on a clean exit and removes the journal.
+ *
+ * Nothing is written for a session without edits.
+ */
+void AutosaveWriter::Worker::finish() {
+  if (flushTimer != nullptr) {
+    flushTimer->stop();
+  }
+  if (!pending.isEmpty() || snapshotLength != -1) {
+    QDir().mkpath(directory);
+    if (compact()) {
+      QFile::remove(journalPath);
+    }
+  }
+  lock.unlock();
+}
+
+/**
+ * @brief Writes the text as the new snapshot and restarts the journal from it.
+ *
+ * Both files are replaced by renaming a completed temporary file, so a crash leaves either the
+ * old or the new version. A journal whose base length does not match the snapshot is stale.
+ *
+ * @return True if the snapshot was written.
+ */
+bool AutosaveWriter::Worker::compact() {
+  QSaveFile snapshot(snapshotPath);
+  if (!snapshot.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  snapshot.write(text.toUtf8());
+  if (!snapshot.commit()) {
+    return false;
+  }
+  snapshotLength = text.size();
+
+  QByteArray header = QString("#base %1\n").arg(snapshotLength).toUtf8();
+  QSaveFile journal(journalPath);
+  if (journal.open(QIODevice::WriteOnly)) {
+    journal.write(header);
+    if (journal.commit()) {
+      journalSize = header.size();
+    }
+  }
+  pending.clear();
+  return true;
+}
+
+AutosaveWriter::AutosaveWriter(const QString &directory, const QString &name, const QString &text, QObject *parent) : QObject(parent), worker(new Worker(directory, name, text)) {
+  worker->moveToThread(&thread);
+  // the worker and its timer are deleted on their own thread once it stops
+  connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+  thread.start(QThread::LowPriority);
+  QMetaObject::invokeMethod(worker, [this]() { worker->start(); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Brings the backup up to date and stops the writer thread.
+ */
+AutosaveWriter::~AutosaveWriter() {
+  QMetaObject::invokeMethod(worker, [this]() { worker->finish(); }, Qt::BlockingQueuedConnection);
+  thread.quit();
+  thread.wait();
+}
+
+/**
+ * @brief Passes an edit of the document to the writer thread.
+ *
+ * @param position Position of the edit in the document before it was made.
+ * @param charsRemoved Number of characters the edit removed.
+ * @param inserted Text the edit inserted.
+ */
+void AutosaveWriter::recordEdit(int position, int charsRemoved, const QString &inserted) {
+  QMetaObject::invokeMethod(worker, [this, position, charsRemoved, inserted]() { worker->applyEdit(position, charsRemoved, inserted); }, Qt::QueuedConnection);
+}
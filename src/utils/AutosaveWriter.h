@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef AUTOSAVEWRITER_H
+#define AUTOSAVEWRITER_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+/**
+ * Keeps a backup of the edited code without touching the whole document on the GUI thread.
+ *
+ * Edits are passed to a writer thread which applies them to its own copy of the text and
+ * appends them to <name>.journal. Once the journal outgrows the text, and when the writer is
+ * destroyed, the text is written to <name>.txt and the journal is restarted, both through an
+ * atomic rename. A clean exit removes the journal, so <name>.txt is then the complete backup.
+ *
+ * The journal starts with "#base <length>", the length of <name>.txt it applies to, followed by
+ * one record per edit: "@<position>,<removed>,<bytes>\n", <bytes> bytes of UTF-8 inserted text
+ * and "\n". Positions and removed lengths count UTF-16 code units.
+ *
+ * A running session holds <name>.lock. Journals of sessions which ended without a clean exit
+ * are replayed into their .txt when the next writer starts in the same directory.
+ */
+class AutosaveWriter final : public QObject {
+  Q_OBJECT
+
+public:
+  AutosaveWriter(const QString &directory, const QString &name, const QString &text, QObject *parent = nullptr);
+  ~AutosaveWriter() override;
+
+  void recordEdit(int position, int charsRemoved, const QString &inserted);
+
+private:
+  class Worker;
+
+  QThread thread;
+  Worker *worker;
+};
+
+#endif // AUTOSAVEWRITER_H
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+
+/**
+ * @brief Fixed size queue for one producer thread and one consumer thread, without locks.
+ *
+ * Each index is written by one side only, the other side reads it with acquire ordering so the
+ * element written before an index was published is visible. Capacity must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class RingBuffer {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  bool push(const T &value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    buffer_[tail & (Capacity - 1)] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+  bool pop(T &value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = buffer_[head & (Capacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+  bool full() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) == Capacity;
+  }
+  // discards everything queued so far, called by the consumer
+  void clear() {
+    head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+private:
+  std::array<T, Capacity> buffer_{};
+  alignas(64) std::atomic<size_t> head_ = 0; // written by the consumer
+  alignas(64) std::atomic<size_t> tail_ = 0; // written by the producer
+};
+
+#endif // RINGBUFFER_H
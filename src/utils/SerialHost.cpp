@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "src/utils/SerialHost.h"
+#include "src/devices/Acia6850.h"
+
+#ifdef _WIN32
+#include <conio.h>
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+namespace {
+  termios originalAttributes;
+} // namespace
+#endif
+
+SerialHost::SerialHost(Acia6850 &device, QObject *parent) : QThread(parent), acia(device) {
+}
+
+SerialHost::~SerialHost() {
+  close();
+}
+
+/**
+ * @brief Serves the line from standard input and output.
+ */
+bool SerialHost::openStandardStreams() {
+  close();
+#ifndef _WIN32
+  inputFd = STDIN_FILENO;
+  outputFd = STDOUT_FILENO;
+  if (isatty(inputFd) && tcgetattr(inputFd, &originalAttributes) == 0) {
+    termios attributes = originalAttributes;
+    attributes.c_lflag &= ~(ICANON | ECHO);
+    attributes.c_iflag &= ~(ICRNL | INLCR);
+    attributes.c_cc[VMIN] = 0;
+    attributes.c_cc[VTIME] = 0;
+    terminalChanged = tcsetattr(inputFd, TCSANOW, &attributes) == 0;
+  }
+#endif
+  path = "stdio";
+  start();
+  return true;
+}
+
+/**
+ * @brief Creates a pseudo-terminal, a terminal program opens devicePath() to talk to the ACIA.
+ */
+bool SerialHost::openPseudoTerminal() {
+  close();
+#ifdef _WIN32
+  error = "Pseudo-terminals are not supported on this platform.";
+  return false;
+#else
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    error = QString("Could not create a pseudo-terminal: %1").arg(strerror(errno));
+    if (master != -1) {
+      ::close(master);
+    }
+    return false;
+  }
+  termios attributes;
+  if (tcgetattr(master, &attributes) == 0) {
+    cfmakeraw(&attributes);
+    tcsetattr(master, TCSANOW, &attributes);
+  }
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+  path = QString::fromLocal8Bit(ptsname(master));
+  slaveFd = ::open(ptsname(master), O_RDWR | O_NOCTTY);
+  inputFd = master;
+  outputFd = master;
+  ownsDescriptors = true;
+  start();
+  return true;
+#endif
+}
+
+/**
+ * @brief Stops serving the line, closes the pseudo-terminal and restores the terminal mode.
+ */
+void SerialHost::close() {
+  if (isRunning()) {
+    requestInterruption();
+    wait();
+  }
+#ifndef _WIN32
+  if (ownsDescriptors && inputFd != -1) {
+    ::close(inputFd);
+  }
+  if (slaveFd != -1) {
+    ::close(slaveFd);
+    slaveFd = -1;
+  }
+#endif
+  restoreTerminal();
+  inputFd = -1;
+  outputFd = -1;
+  ownsDescriptors = false;
+  path.clear();
+}
+
+void SerialHost::restoreTerminal() {
+#ifndef _WIN32
+  if (terminalChanged) {
+    tcsetattr(inputFd, TCSANOW, &originalAttributes);
+    terminalChanged = false;
+  }
+#endif
+}
+
+/**
+ * @brief Moves bytes both ways until interrupted.
+ *
+ * Input is only read while the ACIA can take it, so a program that does not read its serial
+ * port holds the host back instead of losing data. Output the host can not take yet is kept
+ * and written once the descriptor is writable again.
+ */
+void SerialHost::run() {
+  std::vector<uint8_t> incoming;
+  std::vector<uint8_t> outgoing;
+  bool inputOpen = true;
+  while (!isInterruptionRequested()) {
+    uint8_t byte;
+    while (outgoing.size() < 4096 && acia.transmitted.pop(byte)) {
+      outgoing.push_back(byte);
+    }
+    size_t pushed = 0;
+    while (pushed < incoming.size() && acia.received.push(incoming[pushed])) {
+      pushed++;
+    }
+    incoming.erase(incoming.begin(), incoming.begin() + pushed);
+
+#ifdef _WIN32
+    while (incoming.empty() && _kbhit()) {
+      incoming.push_back(static_cast<uint8_t>(_getch()));
+    }
+    if (!outgoing.empty()) {
+      std::fwrite(outgoing.data(), 1, outgoing.size(), stdout);
+      std::fflush(stdout);
+      outgoing.clear();
+    }
+    msleep(pollMilliseconds);
+#else
+    // descriptors with nothing to wait for are left out, a hung up one would end every wait at once
+    bool waitInput = inputOpen && incoming.empty();
+    bool waitOutput = !outgoing.empty();
+    pollfd descriptors[2] = {{waitInput ? inputFd : -1, POLLIN, 0}, {waitOutput ? outputFd : -1, POLLOUT, 0}};
+    if (poll(descriptors, 2, pollMilliseconds) <= 0) {
+      continue;
+    }
+    if (descriptors[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+      uint8_t input[256];
+      ssize_t count = ::read(inputFd, input, sizeof(input));
+      if (count > 0) {
+        incoming.assign(input, input + count);
+      } else if (count == 0 || (errno != EAGAIN && errno != EINTR)) {
+        // end of piped input
+        inputOpen = false;
+      }
+    }
+    if (descriptors[1].revents & POLLOUT) {
+      ssize_t count = ::write(outputFd, outgoing.data(), outgoing.size());
+      if (count > 0) {
+        outgoing.erase(outgoing.begin(), outgoing.begin() + count);
+      }
+    }
+#endif
+  }
+}
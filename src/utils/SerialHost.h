@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024 Vladimir Januš
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SERIALHOST_H
+#define SERIALHOST_H
+
+#include <QString>
+#include <QThread>
+
+#include <stdint.h>
+#include <vector>
+
+class Acia6850;
+
+/**
+ * Connects the serial line of the ACIA to the standard streams or to a pseudo-terminal.
+ *
+ * A thread of its own waits on the host side with poll and moves bytes between it and the
+ * ACIA's ring buffers, the execution thread never blocks on host I/O. The wait times out so
+ * that bytes the ACIA transmits are picked up without a signal from the execution thread.
+ * Standard input is put in raw mode while connected if it is a terminal, Ctrl+C still
+ * interrupts.
+ *
+ * Pseudo-terminals are not available on Windows, there the standard streams are served from
+ * the console.
+ */
+class SerialHost final : public QThread {
+public:
+  explicit SerialHost(Acia6850 &device, QObject *parent = nullptr);
+  ~SerialHost() override;
+
+  bool openStandardStreams();
+  bool openPseudoTerminal();
+  void close();
+
+  QString devicePath() const { return path; }
+  QString errorString() const { return error; }
+
+protected:
+  void run() override;
+
+private:
+  static constexpr int pollMilliseconds = 5;
+
+  Acia6850 &acia;
+  int inputFd = -1;
+  int outputFd = -1;
+  int slaveFd = -1; // held open so the pseudo-terminal does not hang up while no program uses it
+  bool ownsDescriptors = false;
+  bool terminalChanged = false;
+  QString path;
+  QString error;
+
+  void restoreTerminal();
+};
+
+#endif // SERIALHOST_H